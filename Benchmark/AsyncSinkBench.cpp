@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Flossy/AsyncSink.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+std::size_t const messages_per_thread = 100000;
+
+
+// Print percentiles of the latencies of one call, in nanoseconds.
+void report(std::string const& name, std::vector<double>& latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies[std::min(latencies.size() - 1, std::size_t(p * double(latencies.size())))];
+  };
+
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(0)
+            << " p50 " << std::setw(7) << percentile(0.5)
+            << " p90 " << std::setw(7) << percentile(0.9)
+            << " p99 " << std::setw(7) << percentile(0.99)
+            << " p99.9 " << std::setw(8) << percentile(0.999)
+            << " max " << std::setw(9) << latencies.back() << " ns\n";
+}
+
+
+// Call log(thread, i) on the given number of threads and report the latency of the calls.
+template<typename LogT>
+void run_threads(std::string const& name, int threads, LogT const& log) {
+  std::vector<std::vector<double>> latencies(threads);
+  std::vector<std::thread> producers;
+
+  for (int t = 0; t < threads; ++t) {
+    producers.emplace_back([&, t] {
+      auto& result = latencies[t];
+      result.reserve(messages_per_thread);
+      for (std::size_t i = 0; i < messages_per_thread; ++i) {
+        auto const start = clock_type::now();
+        log(t, i);
+        result.push_back(std::chrono::duration<double, std::nano>(clock_type::now() - start).count());
+      }
+    });
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  std::vector<double> all;
+  for (auto const& result : latencies) {
+    all.insert(all.end(), result.begin(), result.end());
+  }
+  report(name + " (" + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)"), all);
+}
+
+
+int main() {
+  int const fd = ::open("/dev/null", O_WRONLY);
+  if (fd < 0) {
+    std::cerr << "Cannot open /dev/null\n";
+    return 1;
+  }
+
+  for (int threads : { 1, 2, 4 }) {
+    // Synchronous: format into a buffer and write it on the calling thread
+    run_threads("format and write", threads, [fd](int t, std::size_t i) {
+      flossy::memory_buffer buffer;
+      flossy::format_to(buffer, "thread {} message {} value {.3f} {}\n", t, i, double(i) * 0.25, "text");
+      flossy::internal::write_all(fd, buffer.data(), buffer.size());
+    });
+
+    flossy::async_sink sink(fd, 65536);
+    run_threads("async_sink", threads, [&sink](int t, std::size_t i) {
+      sink.format("thread {} message {} value {.3f} {}\n", t, i, double(i) * 0.25, "text");
+    });
+    sink.flush();
+  }
+
+  ::close(fd);
+  return 0;
+}
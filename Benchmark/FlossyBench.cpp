@@ -0,0 +1,588 @@
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <charconv>
+#include <cwchar>
+#include <cstdio>
+#include <iomanip>
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Flossy/Flossy.hpp"
+#include "Flossy/BinaryLog.hpp"
+
+// Keeps the compiler from optimizing away the formatted results.
+volatile std::size_t sink = 0;
+
+// Command line options: only run benchmarks whose name contains the filter,
+// and print the results as JSON instead of a table.
+std::string filter;
+bool json_output = false;
+
+struct benchmark_result {
+  std::string name;
+  double ns;
+};
+
+std::vector<benchmark_result> results;
+
+
+// Run func (which formats one value and returns the number of characters
+// produced) repeatedly for about a tenth of a second and report the average
+// time per call.
+void run_benchmark(std::string const& name, std::function<std::size_t(std::size_t)> const& func) {
+  using clock = std::chrono::steady_clock;
+
+  if (name.find(filter) == std::string::npos) {
+    return;
+  }
+
+  // Warm up caches and branch predictors
+  for (std::size_t i = 0; i < 1000; ++i) {
+    sink = sink + func(i);
+  }
+
+  std::size_t iterations = 0;
+  auto const start = clock::now();
+  auto elapsed = clock::duration::zero();
+
+  do {
+    for (std::size_t i = 0; i < 1000; ++i, ++iterations) {
+      sink = sink + func(iterations);
+    }
+    elapsed = clock::now() - start;
+  } while (elapsed < std::chrono::milliseconds(100));
+
+  auto const ns = std::chrono::duration<double, std::nano>(elapsed).count() / double(iterations);
+  results.push_back({ name, ns });
+
+  if (!json_output) {
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(10)
+              << std::fixed << std::setprecision(2) << ns << " ns/op\n";
+  }
+}
+
+
+// Print the results as JSON, together with the configuration they were
+// measured with, so runs of different versions can be compared by scripts.
+void print_json() {
+  auto quoted = [](std::string const& text) {
+    std::string result = "\"";
+    for (char c : text) {
+      if (c == '"' || c == '\\') {
+        result += '\\';
+      }
+      result += c;
+    }
+    return result + "\"";
+  };
+
+#ifdef FLOSSY_SSE2
+  bool const simd = true;
+#else
+  bool const simd = false;
+#endif
+
+  std::cout << "{\n  \"float_method\": " << FLOSSY_FLOAT_METHOD
+            << ",\n  \"simd\": " << (simd ? "true" : "false")
+            << ",\n  \"results\": [\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    std::cout << "    { \"name\": " << quoted(results[i].name) << ", \"ns_per_op\": "
+              << std::fixed << std::setprecision(2) << results[i].ns
+              << (i + 1 < results.size() ? " },\n" : " }\n");
+  }
+  std::cout << "  ]\n}\n";
+}
+
+
+// Random values with the given number of decimal digits
+template<typename ValueT>
+std::vector<ValueT> values_with_digits(int digits, bool negative = false) {
+  std::mt19937_64 rng(digits);
+  uint64_t low = 1;
+  for (int i = 1; i < digits; ++i) {
+    low *= 10;
+  }
+  uint64_t const high = std::min<uint64_t>(digits >= 20 ? std::numeric_limits<uint64_t>::max() : low * 10 - 1,
+                                           uint64_t(std::numeric_limits<ValueT>::max()));
+  std::uniform_int_distribution<uint64_t> distribution(digits == 1 ? 0 : low, high);
+
+  std::vector<ValueT> values(1024);
+  for (auto& value : values) {
+    value = ValueT(distribution(rng));
+    if (negative) {
+      value = ValueT(0) - value;
+    }
+  }
+  return values;
+}
+
+
+template<typename ValueT>
+void benchmark_integers(std::string const& type_name, std::string const& format,
+                        std::vector<int> const& digit_counts, bool negative = false) {
+  for (int digits : digit_counts) {
+    auto const values = values_with_digits<ValueT>(digits, negative);
+    std::string output;
+
+    run_benchmark(type_name + " " + format + " (" + (negative ? "negative, " : "")
+                  + std::to_string(digits) + " digits)",
+                  [&](std::size_t i) {
+      output.clear();
+      flossy::internal::format_it(std::back_inserter(output), format.begin(), format.end(),
+                                  values[i % values.size()]);
+      return output.size();
+    });
+  }
+}
+
+
+// Same as above, but formatting to contiguous memory through a pointer
+template<typename ValueT>
+void benchmark_integers_to_pointer(std::string const& type_name, std::string const& format,
+                                   std::vector<int> const& digit_counts) {
+  for (int digits : digit_counts) {
+    auto const values = values_with_digits<ValueT>(digits);
+    char output[128];
+
+    run_benchmark(type_name + " " + format + " to pointer (" + std::to_string(digits) + " digits)",
+                  [&](std::size_t i) {
+      char* end = flossy::internal::format_it(&output[0], format.begin(), format.end(),
+                                              values[i % values.size()]);
+      return std::size_t(end - output);
+    });
+  }
+}
+
+
+// Literal text, string values and padding appended to a string or vector
+template<typename Container>
+void benchmark_bulk_output(std::string const& container_name) {
+  std::string const literal_format = "A line with a lot more literal text than values: {} "
+                                     "followed by even more literal text at the end.";
+  std::string const string_format = "{<40s}|{>40s}|";
+  std::string const value = "some_component_name";
+  Container output;
+
+  run_benchmark("literal text to " + container_name, [&](std::size_t i) {
+    output.clear();
+    flossy::internal::format_it(std::back_inserter(output), literal_format.begin(),
+                                literal_format.end(), i);
+    return output.size();
+  });
+
+  run_benchmark("padded strings to " + container_name, [&](std::size_t) {
+    output.clear();
+    flossy::internal::format_it(std::back_inserter(output), string_format.begin(),
+                                string_format.end(), value, value);
+    return output.size();
+  });
+}
+
+
+// Format strings with four placeholders and the given amount of literal text
+// around each, formatted to a pointer. Shows the cost of scanning literal
+// text for the next placeholder (compare with FlossyBenchNoSimd).
+void benchmark_literal_ratio() {
+  for (std::size_t literal_length : { 0, 4, 16, 64, 256, 1024 }) {
+    std::string const literal(literal_length, '.');
+    std::string const format_str = literal + "{}" + literal + "{}" + literal + "{}" + literal + "{}" + literal;
+    std::vector<char> output(format_str.size() + 64);
+
+    run_benchmark("literal text " + std::to_string(literal_length) + " chars per value (4 values)",
+                  [&](std::size_t i) {
+      char* end = flossy::internal::format_it(output.data(), format_str.begin(), format_str.end(),
+                                              i, i, i, i);
+      return std::size_t(end - output.data());
+    });
+  }
+}
+
+
+// format_to_n into a stack buffer, once with enough space and once with a
+// buffer that is full after the first value
+void benchmark_format_to_n() {
+  auto const values = values_with_digits<uint64_t>(10);
+  std::string const format_str = "values: {} {} {} {} {} {} {} {}";
+
+  for (std::size_t size : { std::size_t(128), std::size_t(12) }) {
+    run_benchmark("format_to_n 8 values (buffer size " + std::to_string(size) + ")",
+                  [&](std::size_t i) {
+      char buffer[128];
+      auto const& v = values[i % values.size()];
+      return flossy::format_to_n(buffer, size, format_str, v, v, v, v, v, v, v, v).written;
+    });
+  }
+}
+
+
+// Short messages, each formatted into a new string or into a reused memory
+// buffer, which does not allocate memory
+void benchmark_memory_buffer() {
+  auto const values = values_with_digits<uint64_t>(10);
+  std::string const name = "some_component_name";
+  std::string const format_str = "request {} from {} took {} us";
+
+  run_benchmark("short message, format() to new string", [&](std::size_t i) {
+    return flossy::format(format_str, values[i % values.size()], name, i).size();
+  });
+
+  flossy::memory_buffer buffer;
+  run_benchmark("short message, format_to(memory_buffer)", [&](std::size_t i) {
+    buffer.clear();
+    return flossy::format_to(buffer, format_str, values[i % values.size()], name, i).size();
+  });
+}
+
+
+// Long lines written to a file stream: flossy::format to the stream, the
+// ostream_iterator previously used by it, and fprintf
+void benchmark_streams() {
+  auto const values = values_with_digits<uint64_t>(10);
+  std::string const name = "some_component_name";
+  std::string const format_str = "| field {} = {15} ({<30s}) | field {} = {15} ({<30s}) "
+                                 "| field {} = {15} ({<30s}) | field {} = {15} ({<30s})\n";
+  char const* const printf_format = "| field %lu = %15zu (%-30s) | field %lu = %15zu (%-30s) "
+                                    "| field %lu = %15zu (%-30s) | field %lu = %15zu (%-30s)\n";
+
+  std::ofstream stream("/dev/null");
+  std::FILE* const file = std::fopen("/dev/null", "w");
+
+  run_benchmark("stream line, format(ostream&)", [&](std::size_t i) {
+    auto const v = values[i % values.size()];
+    flossy::format(stream, format_str, v, i, name, v, i, name, v, i, name, v, i, name);
+    return std::size_t(1);
+  });
+
+  run_benchmark("stream line, ostream_iterator", [&](std::size_t i) {
+    auto const v = values[i % values.size()];
+    flossy::internal::format_it(std::ostream_iterator<char>(stream), format_str.begin(), format_str.end(),
+                                v, i, name, v, i, name, v, i, name, v, i, name);
+    return std::size_t(1);
+  });
+
+  run_benchmark("stream line, fprintf", [&](std::size_t i) {
+    auto const v = (unsigned long) values[i % values.size()];
+    return std::size_t(std::fprintf(file, printf_format, v, i, name.c_str(), v, i, name.c_str(),
+                                    v, i, name.c_str(), v, i, name.c_str()));
+  });
+
+  std::fclose(file);
+}
+
+
+// flossy::format of long report lines with many values, producing a new
+// string every time
+void benchmark_report_lines() {
+  auto const values = values_with_digits<uint64_t>(10);
+  std::string const name = "some_component_name";
+
+  std::string format_str;
+  for (int i = 0; i < 32; ++i) {
+    format_str += "| field {} = {15} ({<30s}) ";
+  }
+
+  for (int fields : { 1, 8, 32 }) {
+    std::string const line_format(format_str, 0, format_str.size() * fields / 32);
+
+    run_benchmark("format() report line (" + std::to_string(fields * 3) + " values)",
+                  [&](std::size_t i) {
+      auto const& v = values[i % values.size()];
+      return flossy::format(line_format, v, i, name, v, i, name, v, i, name, v, i, name,
+                            v, i, name, v, i, name, v, i, name, v, i, name,
+                            v, i, name, v, i, name, v, i, name, v, i, name,
+                            v, i, name, v, i, name, v, i, name, v, i, name,
+                            v, i, name, v, i, name, v, i, name, v, i, name,
+                            v, i, name, v, i, name, v, i, name, v, i, name,
+                            v, i, name, v, i, name, v, i, name, v, i, name,
+                            v, i, name, v, i, name, v, i, name, v, i, name).size();
+    });
+  }
+}
+
+
+// Trace messages written to a file: formatted to text in a memory buffer,
+// and stored as binary records to be formatted later
+void benchmark_binary_log() {
+  auto const values = values_with_digits<uint64_t>(10);
+  std::string const name = "some_component_name";
+  std::FILE* const file = std::fopen("/dev/null", "w");
+
+  flossy::memory_buffer buffer;
+  run_benchmark("trace message, format_to(memory_buffer) and write", [&](std::size_t i) {
+    auto const size = flossy::format_to(buffer, "request {} from {} took {.2f} us\n",
+                                        values[i % values.size()], name, double(i) * 0.25).size();
+    if (buffer.size() > 60000) {
+      flossy::internal::write_all(fileno(file), buffer.data(), buffer.size());
+      buffer.clear();
+    }
+    return size;
+  });
+
+  flossy::binary_writer writer(fileno(file));
+  run_benchmark("trace message, binary_writer", [&](std::size_t i) {
+    writer.format("request {} from {} took {.2f} us\n", values[i % values.size()], name, double(i) * 0.25);
+    return std::size_t(1);
+  });
+  writer.flush();
+
+  std::fclose(file);
+}
+
+
+// Integers in all bases, formatted to a pointer by flossy, compared with
+// snprintf, std::to_chars and std::ostringstream (the latter two without a
+// format string, neither printf nor streams have binary output)
+void benchmark_integer_baselines() {
+  struct base_case {
+    int base;
+    std::string format;
+    char const* printf_format;
+    std::ios::fmtflags stream_flags;
+  };
+
+  auto const values = values_with_digits<uint64_t>(10);
+  std::ostringstream stream;
+  char output[128];
+
+  for (auto const& base : { base_case{ 10, "{}", "%llu", std::ios::dec }, base_case{ 16, "{x}", "%llx", std::ios::hex },
+                            base_case{ 8, "{o}", "%llo", std::ios::oct }, base_case{ 2, "{b}", nullptr, std::ios::dec } }) {
+    std::string const name = "uint64_t base " + std::to_string(base.base) + " (10 digits), ";
+
+    run_benchmark(name + "flossy", [&](std::size_t i) {
+      char* end = flossy::internal::format_it(&output[0], base.format.begin(), base.format.end(),
+                                              values[i % values.size()]);
+      return std::size_t(end - output);
+    });
+
+    if (base.printf_format) {
+      run_benchmark(name + "snprintf", [&](std::size_t i) {
+        return std::size_t(std::snprintf(output, sizeof(output), base.printf_format,
+                                         (unsigned long long) values[i % values.size()]));
+      });
+
+      run_benchmark(name + "ostringstream", [&](std::size_t i) {
+        stream.str(std::string());
+        stream.flags(base.stream_flags);
+        stream << values[i % values.size()];
+        return std::size_t(stream.tellp());
+      });
+    }
+
+    run_benchmark(name + "to_chars", [&](std::size_t i) {
+      auto const result = std::to_chars(output, output + sizeof(output), values[i % values.size()], base.base);
+      return std::size_t(result.ptr - output);
+    });
+  }
+}
+
+
+// Floats between 1e-6 and 1e6 (with both signs) in fixed and scientific
+// notation at several precisions
+void benchmark_float_baselines() {
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> exponents(-6, 6);
+  std::vector<double> values(1024);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    values[i] = std::pow(10.0, exponents(rng)) * (i % 2 ? -1 : 1);
+  }
+
+  std::ostringstream stream;
+  char output[128];
+
+  for (bool scientific : { false, true }) {
+    for (int precision : { 0, 2, 6, 12 }) {
+      std::string const format_str = "{." + std::to_string(precision) + (scientific ? "e}" : "f}");
+      std::string const name = std::string("double ") + (scientific ? "scientific" : "fixed")
+                               + " precision " + std::to_string(precision) + ", ";
+
+      run_benchmark(name + "flossy", [&](std::size_t i) {
+        char* end = flossy::internal::format_it(&output[0], format_str.begin(), format_str.end(),
+                                                values[i % values.size()]);
+        return std::size_t(end - output);
+      });
+
+      run_benchmark(name + "snprintf", [&](std::size_t i) {
+        return std::size_t(std::snprintf(output, sizeof(output), scientific ? "%.*e" : "%.*f", precision,
+                                         values[i % values.size()]));
+      });
+
+      run_benchmark(name + "ostringstream", [&](std::size_t i) {
+        stream.str(std::string());
+        stream.flags(scientific ? std::ios::scientific : std::ios::fixed);
+        stream.precision(precision);
+        stream << values[i % values.size()];
+        return std::size_t(stream.tellp());
+      });
+
+#ifdef __cpp_lib_to_chars
+      run_benchmark(name + "to_chars", [&](std::size_t i) {
+        auto const result = std::to_chars(output, output + sizeof(output), values[i % values.size()],
+                                          scientific ? std::chars_format::scientific : std::chars_format::fixed,
+                                          precision);
+        return std::size_t(result.ptr - output);
+      });
+#endif
+    }
+  }
+}
+
+
+// Strings aligned left and right in fields of 30 characters
+void benchmark_string_baselines() {
+  std::string const format_str = "{<30s}|{>30s}|";
+  std::string const left = "some_component_name";
+  std::string const right = "short";
+  std::ostringstream stream;
+  char output[128];
+
+  run_benchmark("padded strings, flossy", [&](std::size_t) {
+    char* end = flossy::internal::format_it(&output[0], format_str.begin(), format_str.end(), left, right);
+    return std::size_t(end - output);
+  });
+
+  run_benchmark("padded strings, snprintf", [&](std::size_t) {
+    return std::size_t(std::snprintf(output, sizeof(output), "%-30s|%30s|", left.c_str(), right.c_str()));
+  });
+
+  run_benchmark("padded strings, ostringstream", [&](std::size_t) {
+    stream.str(std::string());
+    stream << std::left << std::setw(30) << left << '|' << std::right << std::setw(30) << right << '|';
+    return std::size_t(stream.tellp());
+  });
+}
+
+
+// A log message with twelve values of different types
+void benchmark_many_arguments() {
+  auto const values = values_with_digits<uint64_t>(10);
+  std::string const format_str = "{} {} {} {.2f} {} {x} {} {.3e} {} {} {<12s} {}";
+  std::string const name = "some_component_name";
+  std::ostringstream stream;
+  char output[512];
+
+  run_benchmark("12 values, flossy", [&](std::size_t i) {
+    auto const v = values[i % values.size()];
+    double const d = double(v) / 1000.0;
+    char* end = flossy::internal::format_it(&output[0], format_str.begin(), format_str.end(),
+                                            v, i, name, d, -int(i), v, i, d, name, v, "text", i);
+    return std::size_t(end - output);
+  });
+
+  flossy::parsed_format<char> const parsed(format_str);
+  run_benchmark("12 values, flossy parsed_format", [&](std::size_t i) {
+    auto const v = values[i % values.size()];
+    double const d = double(v) / 1000.0;
+    char* end = parsed.format_to(&output[0], v, i, name, d, -int(i), v, i, d, name, v, "text", i);
+    return std::size_t(end - output);
+  });
+
+  flossy::parsed_format<char, 12> const checked(format_str);
+  run_benchmark("12 values, flossy parsed_format (checked)", [&](std::size_t i) {
+    auto const v = values[i % values.size()];
+    double const d = double(v) / 1000.0;
+    char* end = checked.format_to(&output[0], v, i, name, d, -int(i), v, i, d, name, v, "text", i);
+    return std::size_t(end - output);
+  });
+
+  run_benchmark("12 values, snprintf", [&](std::size_t i) {
+    auto const v = (unsigned long long) values[i % values.size()];
+    double const d = double(v) / 1000.0;
+    return std::size_t(std::snprintf(output, sizeof(output), "%llu %zu %s %.2f %d %llx %zu %.3e %s %llu %-12s %zu",
+                                     v, i, name.c_str(), d, -int(i), v, i, d, name.c_str(), v, "text", i));
+  });
+
+  run_benchmark("12 values, ostringstream", [&](std::size_t i) {
+    auto const v = values[i % values.size()];
+    double const d = double(v) / 1000.0;
+    stream.str(std::string());
+    stream << v << ' ' << i << ' ' << name << ' ' << std::fixed << std::setprecision(2) << d << ' ' << -int(i)
+           << ' ' << std::hex << v << std::dec << ' ' << i << ' ' << std::scientific << std::setprecision(3) << d
+           << ' ' << name << ' ' << v << ' ' << std::left << std::setw(12) << "text" << std::right << ' ' << i;
+    return std::size_t(stream.tellp());
+  });
+}
+
+
+// Wide character output of integers, floats and strings
+void benchmark_wide() {
+  auto const values = values_with_digits<uint64_t>(10);
+  std::wstring const format_str = L"{} {x} {.3f} {<20s}|";
+  std::wstring const name = L"some_component_name";
+  std::wostringstream stream;
+  wchar_t output[128];
+
+  run_benchmark("wchar_t message, flossy", [&](std::size_t i) {
+    auto const v = values[i % values.size()];
+    wchar_t* end = flossy::internal::format_it(&output[0], format_str.begin(), format_str.end(),
+                                               v, v, double(v) / 1000.0, std::wstring_view(name));
+    return std::size_t(end - output);
+  });
+
+  run_benchmark("wchar_t message, swprintf", [&](std::size_t i) {
+    auto const v = (unsigned long long) values[i % values.size()];
+    return std::size_t(std::swprintf(output, 128, L"%llu %llx %.3f %-20ls|", v, v, double(v) / 1000.0,
+                                     name.c_str()));
+  });
+
+  run_benchmark("wchar_t message, wostringstream", [&](std::size_t i) {
+    auto const v = values[i % values.size()];
+    stream.str(std::wstring());
+    stream << std::dec << v << L' ' << std::hex << v << L' ' << std::dec << std::fixed << std::setprecision(3)
+           << double(v) / 1000.0 << L' ' << std::left << std::setw(20) << name << std::right << L'|';
+    return std::size_t(stream.tellp());
+  });
+}
+
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    std::string const argument = argv[i];
+    if (argument == "--json") {
+      json_output = true;
+    }
+    else {
+      filter = argument;
+    }
+  }
+
+  benchmark_integers<uint32_t>("uint32_t", "{}", { 1, 3, 5, 8, 10 });
+  benchmark_integers<uint64_t>("uint64_t", "{}", { 1, 5, 10, 15, 20 });
+  benchmark_integers<int64_t>("int64_t", "{}", { 1, 5, 10, 15, 19 });
+  benchmark_integers<int64_t>("int64_t", "{}", { 1, 5, 10, 15, 19 }, true);
+
+  benchmark_integers<uint32_t>("uint32_t", "{x}", { 3, 10 });
+  benchmark_integers<uint64_t>("uint64_t", "{x}", { 5, 20 });
+  benchmark_integers<uint64_t>("uint64_t", "{o}", { 5, 20 });
+  benchmark_integers<uint64_t>("uint64_t", "{b}", { 5, 20 });
+
+  benchmark_integers<uint64_t>("uint64_t", "{_020}", { 5, 20 });
+  benchmark_integers_to_pointer<uint64_t>("uint64_t", "{}", { 1, 5, 10, 15, 20 });
+  benchmark_integers_to_pointer<uint64_t>("uint64_t", "{x}", { 5, 20 });
+  benchmark_integers_to_pointer<uint64_t>("uint64_t", "{_020}", { 5, 20 });
+
+  benchmark_bulk_output<std::string>("string");
+  benchmark_bulk_output<std::vector<char>>("vector");
+  benchmark_literal_ratio();
+  benchmark_format_to_n();
+  benchmark_memory_buffer();
+  benchmark_report_lines();
+  benchmark_streams();
+  benchmark_binary_log();
+
+  benchmark_integer_baselines();
+  benchmark_float_baselines();
+  benchmark_string_baselines();
+  benchmark_many_arguments();
+  benchmark_wide();
+
+  if (json_output) {
+    print_json();
+  }
+}
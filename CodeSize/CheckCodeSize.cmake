@@ -0,0 +1,167 @@
+#[[ Measures the code generated for the call patterns in CodeSize/Patterns.
+
+Run by the FlossyCodeSize target (-DFLOSSY_CHECK_CODE_SIZE=ON) as
+
+    cmake -DOBJECTS=<a|b|...> -DNM=<nm> -DCOMPILER=<id and version>
+          -DPATTERNS=<dir> -DBASELINE=<file> -DREPORT=<file>
+          -DTHRESHOLD=<percent> [-DUPDATE=ON] -P CheckCodeSize.cmake
+
+For every object file (one per pattern) it records the code size (sum of
+the sizes of all functions), the object file size, the number of flossy
+functions compiled out of line (instantiations) and the largest functions.
+
+The report is written to REPORT. If BASELINE was recorded with the same
+compiler, the check fails when the code size of a pattern grows by more than
+THRESHOLD percent or it gets more instantiations. With UPDATE=ON, the
+current results are written to BASELINE instead.
+
+A pattern source in PATTERNS may contain a line
+
+    // Excluded symbols: <regular expression>
+
+and the check fails with any compiler if a function of its object file
+matches the expression, e.g. float formatters in integer-only calls.
+]]
+
+string(REPLACE "|" ";" OBJECTS "${OBJECTS}")
+
+set(report "Code size of flossy call patterns (${COMPILER})\n\n")
+set(results "")
+set(excluded "")
+
+foreach (object ${OBJECTS})
+    get_filename_component(pattern "${object}" NAME)
+    string(REGEX REPLACE "\\.cpp\\.(o|obj)$" "" pattern "${pattern}")
+
+    execute_process(COMMAND "${NM}" -C -S --defined-only "${object}"
+            OUTPUT_VARIABLE symbols RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${NM} failed on ${object}")
+    endif ()
+
+    # Lines: address size type name. Only functions (text symbols) count.
+    string(REPLACE ";" "," symbols "${symbols}")
+    string(REPLACE "\n" ";" symbols "${symbols}")
+
+    set(exclude "")
+    if (EXISTS "${PATTERNS}/${pattern}.cpp")
+        file(STRINGS "${PATTERNS}/${pattern}.cpp" exclude REGEX "^// Excluded symbols: ")
+        string(REGEX REPLACE "^// Excluded symbols: " "" exclude "${exclude}")
+    endif ()
+
+    set(code_size 0)
+    set(flossy_functions "")
+    set(functions "")
+
+    foreach (line ${symbols})
+        if (line MATCHES "^[0-9a-fA-F]+ ([0-9a-fA-F]+) [tTwW] (.*)$")
+            set(name "${CMAKE_MATCH_2}")
+            math(EXPR size "0x${CMAKE_MATCH_1}")
+            math(EXPR code_size "${code_size} + ${size}")
+
+            # Parts and clones of a function made by the optimizer (like
+            # "[clone .cold]") are counted as one function.
+            string(REGEX REPLACE "( \\[clone [^]]*\\])+$" "" function_name "${name}")
+            if (function_name MATCHES "flossy::")
+                list(APPEND flossy_functions "${function_name}")
+            endif ()
+            if (exclude AND name MATCHES "${exclude}")
+                string(APPEND excluded "${pattern}: ${name}\n")
+            endif ()
+
+            # Sortable by size: zero padded size, then the name
+            string(LENGTH "${size}" length)
+            math(EXPR padding "10 - ${length}")
+            string(REPEAT "0" ${padding} zeros)
+            string(SUBSTRING "${name}" 0 150 name)
+            list(APPEND functions "${zeros}${size} ${name}")
+        endif ()
+    endforeach ()
+
+    list(REMOVE_DUPLICATES flossy_functions)
+    list(LENGTH flossy_functions instantiations)
+    file(SIZE "${object}" object_size)
+
+    string(APPEND report "${pattern}: ${code_size} bytes of code, ${instantiations} flossy functions, "
+            "object file ${object_size} bytes\n")
+
+    list(SORT functions)
+    list(REVERSE functions)
+    list(LENGTH functions count)
+    if (count GREATER 5)
+        list(SUBLIST functions 0 5 functions)
+    endif ()
+    foreach (function ${functions})
+        string(REGEX REPLACE "^0*([0-9]+) (.*)$" "    \\1 \\2" function "${function}")
+        string(APPEND report "${function}\n")
+    endforeach ()
+
+    list(APPEND results "${pattern} ${code_size} ${instantiations}")
+endforeach ()
+
+file(WRITE "${REPORT}" "${report}")
+message("${report}")
+
+if (excluded)
+    message(FATAL_ERROR "Excluded symbols compiled in:\n${excluded}")
+endif ()
+
+if (UPDATE)
+    string(REPLACE ";" "\n" lines "${results}")
+    file(WRITE "${BASELINE}" "compiler ${COMPILER}\n${lines}\n")
+    message("Baseline written to ${BASELINE}")
+    return()
+endif ()
+
+if (NOT EXISTS "${BASELINE}")
+    message("No baseline at ${BASELINE}, nothing to compare with.")
+    return()
+endif ()
+
+file(STRINGS "${BASELINE}" baseline)
+list(GET baseline 0 baseline_compiler)
+if (NOT baseline_compiler STREQUAL "compiler ${COMPILER}")
+    message("The baseline was recorded with a different compiler (${baseline_compiler}), "
+            "not comparing. Update it with the FlossyCodeSizeBaseline target.")
+    return()
+endif ()
+
+set(failures "")
+
+foreach (result ${results})
+    string(REPLACE " " ";" result "${result}")
+    list(GET result 0 pattern)
+    list(GET result 1 code_size)
+    list(GET result 2 instantiations)
+
+    set(found FALSE)
+    foreach (line ${baseline})
+        if (line MATCHES "^${pattern} ([0-9]+) ([0-9]+)$")
+            set(found TRUE)
+            set(baseline_size ${CMAKE_MATCH_1})
+            set(baseline_instantiations ${CMAKE_MATCH_2})
+        endif ()
+    endforeach ()
+
+    if (NOT found)
+        message("${pattern}: not in the baseline")
+        continue()
+    endif ()
+
+    math(EXPR limit "${baseline_size} + ${baseline_size} * ${THRESHOLD} / 100")
+    if (code_size GREATER limit)
+        string(APPEND failures "${pattern}: code size ${code_size} bytes, baseline ${baseline_size} bytes "
+                "(limit ${limit} bytes)\n")
+    endif ()
+    if (instantiations GREATER baseline_instantiations)
+        string(APPEND failures "${pattern}: ${instantiations} flossy functions, "
+                "baseline ${baseline_instantiations}\n")
+    endif ()
+endforeach ()
+
+if (failures)
+    message(FATAL_ERROR "Code size regression:\n${failures}"
+            "If the growth is intended, update the baseline with the FlossyCodeSizeBaseline target.")
+endif ()
+
+message("Code size within ${THRESHOLD}% of the baseline.")
@@ -0,0 +1,7 @@
+// A format string compiled with FLOSSY_FMT
+#include "Flossy/Flossy.hpp"
+
+std::string compiled(int a, double b, std::string const& c)
+{
+	return flossy::format(FLOSSY_FMT("compiled {} {.2f} {<10s}"), a, b, c);
+}
@@ -0,0 +1,7 @@
+// Floats with the default, fixed and scientific formats
+#include "Flossy/Flossy.hpp"
+
+std::string floats(double a, float b)
+{
+	return flossy::format("{} {.2f} {.3e} {_+010.1f}", a, b, a, b);
+}
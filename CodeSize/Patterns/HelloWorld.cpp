@@ -0,0 +1,8 @@
+// The call captured in Documentation/Compiler/Explorer
+// Excluded symbols: float|double
+#include "Flossy/Flossy.hpp"
+
+std::string hello_world()
+{
+	return flossy::format("Hello World {}.", 42);
+}
@@ -0,0 +1,7 @@
+// Integers of several types in all bases, with padding
+#include "Flossy/Flossy.hpp"
+
+std::string integers(int a, unsigned long long b, short c)
+{
+	return flossy::format("{} {x} {o} {b} {_08d} {>+6}", a, b, c, a, b, c);
+}
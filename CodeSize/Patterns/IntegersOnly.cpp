@@ -0,0 +1,9 @@
+// Integers and strings with a runtime format string, which must not compile
+// in any float formatter
+// Excluded symbols: float|double
+#include "Flossy/Flossy.hpp"
+
+std::string integers_only(int a, long long b, char const* c)
+{
+	return flossy::format("{} {x} {_08d} {}", a, b, a, c);
+}
@@ -0,0 +1,8 @@
+// A log line with twelve values of mixed types
+#include "Flossy/Flossy.hpp"
+
+std::string many_values(unsigned long long a, int b, std::string const& c, double d)
+{
+	return flossy::format("{} {} {} {.2f} {} {x} {} {.3e} {} {} {<12s} {}",
+			a, b, c, d, -b, a, b, d, c, a, "text", b);
+}
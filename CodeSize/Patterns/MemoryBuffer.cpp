@@ -0,0 +1,8 @@
+// Formatting without allocations: into a memory buffer and a fixed array
+#include "Flossy/Flossy.hpp"
+
+std::size_t memory_buffer(flossy::memory_buffer& buffer, char (& array)[64], int a, char const* b)
+{
+	auto const message = flossy::format_to(buffer, "request {} from {}", a, b);
+	return message.size() + flossy::format_to_n(array, sizeof(array), "request {} from {}", a, b).written;
+}
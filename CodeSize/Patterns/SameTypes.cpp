@@ -0,0 +1,10 @@
+// Several format strings with the same value types, which share the
+// formatting code
+#include "Flossy/Flossy.hpp"
+
+std::string same_types(int a, std::string const& b)
+{
+	return flossy::format("first {} {}", a, b)
+		   + flossy::format("second {x} {<10s}", a, b)
+		   + flossy::format("third {} and {}", a, b);
+}
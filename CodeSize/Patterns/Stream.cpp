@@ -0,0 +1,7 @@
+// Formatting to an output stream
+#include "Flossy/Flossy.hpp"
+
+void stream(std::ostream& out, int a, std::string const& b)
+{
+	flossy::format(out, "value {} name {}\n", a, b);
+}
@@ -0,0 +1,7 @@
+// Strings of all kinds, aligned in fields
+#include "Flossy/Flossy.hpp"
+
+std::string strings(std::string const& a, char const* b, std::string_view c)
+{
+	return flossy::format("{<20s}|{>20s}|{}", a, b, c);
+}
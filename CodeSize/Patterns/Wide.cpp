@@ -0,0 +1,7 @@
+// Wide character format strings and values
+#include "Flossy/Flossy.hpp"
+
+std::wstring wide(int a, double b, std::wstring const& c)
+{
+	return flossy::format(L"{} {.2f} {<10s}", a, b, c);
+}
@@ -0,0 +1,447 @@
+/*
+    flossy 1.0
+
+    This project is free software; you can redistribute it and/or modify it
+    under the terms of the MIT license:
+
+    Copyright (c) 2016 Florian Kesseler
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+*/
+
+
+/*
+  Asynchronous output of formatted messages to a file descriptor. This is an
+  optional part of flossy, it needs a threads library (e.g. -pthread).
+
+  Threads calling async_sink::format only copy the format string pointer and
+  the values into a slot of a lock-free ring buffer. A background thread
+  takes the messages out in order, formats them with flossy::format_to into a
+  memory buffer and writes that to the file descriptor in large chunks.
+
+    flossy::async_sink sink(STDERR_FILENO);
+    sink.format("request {} took {} us\n", id, duration);
+
+  Format strings are stored as pointers, so they must be string literals (or
+  otherwise outlive the sink) or FLOSSY_FMT strings. C strings and string
+  views passed as values are copied into strings, all other values are
+  copied as they are. The values of one message must fit into
+  async_sink::record_capacity bytes, which is checked at compile time. If
+  copying a value throws, format passes the exception on and the message
+  counts as failed. Exceptions thrown while formatting on the background
+  thread are caught there, and the message is dropped and counted as failed.
+
+  If the ring buffer is full, format either waits for the background thread
+  to make room (queue_full_policy::block, the default) or drops the message
+  and counts it (queue_full_policy::drop).
+
+  flush() waits until all messages passed to format before have been written.
+  The destructor writes all remaining messages before it returns.
+*/
+
+
+#ifndef FLOSSY_ASYNC_SINK_H_INCLUDED
+#define FLOSSY_ASYNC_SINK_H_INCLUDED
+
+#include "Flossy/Flossy.hpp"
+#include "Flossy/FileDescriptor.hpp"
+
+#include <stdexcept>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace flossy
+{
+
+	// What async_sink::format does if the ring buffer is full
+	enum class queue_full_policy
+	{
+		// Wait until the background thread makes room
+		block,
+		// Drop the message, see async_sink::dropped
+		drop
+	};
+
+
+	namespace internal
+	{
+		// Type a value passed to async_sink::format is stored as. Strings that
+		// are not owned by the value are copied.
+		template<typename ValueT, typename DecayedT = std::decay_t<ValueT>>
+		using async_value_t = std::conditional_t<
+				std::is_same<DecayedT, char const*>::value || std::is_same<DecayedT, char*>::value
+				|| std::is_same<DecayedT, std::string_view>::value,
+				std::string, DecayedT>;
+
+
+		// A message in the ring buffer: the format string and copies of the values.
+		template<typename FormatT, typename... ValueTs>
+		struct async_record
+		{
+			FormatT format_str;
+			std::tuple<ValueTs...> values;
+
+
+			// Append the message to buffer and destroy the record, which lives in
+			// the given storage.
+			static bool consume(void* storage, memory_buffer& buffer)
+			{
+				auto* const record = static_cast<async_record*>(storage);
+				bool success = true;
+
+				// Invalid format strings are only found here, drop the message. So
+				// are values whose format_element throws anything, which must not
+				// escape the background thread.
+#ifdef FLOSSY_NO_EXCEPTIONS
+				success = std::apply([&](ValueTs const& ... values)
+				{
+					return bool(try_format_to(buffer, record->format_str, values...));
+				}, record->values);
+#else
+				std::size_t const size = buffer.size();
+
+				try
+				{
+					std::apply([&](ValueTs const& ... values)
+					{
+						format_to(buffer, record->format_str, values...);
+					}, record->values);
+				}
+				catch (...)
+				{
+					buffer.resize(size);
+					success = false;
+				}
+#endif
+
+				record->~async_record();
+				return success;
+			}
+		};
+	}
+
+
+	/**
+	 * @page Asynchronous Sink.
+	 *
+	 * Formats messages on a background thread and writes them to a file
+	 * descriptor. See the description at the top of this file.
+	 *
+	 * The ring buffer between the calling threads and the background thread
+	 * is a bounded multi-producer queue as described by Dmitry Vyukov: every
+	 * slot has a sequence number telling whether it is free or holds a
+	 * message, so producers only compete for the enqueue position and never
+	 * take a lock.
+	 *
+	 * @example
+	 * @code
+	 * flossy::async_sink sink(fd, 4096, flossy::queue_full_policy::drop);
+	 * sink.format("request {} took {} us\n", id, duration);
+	 * sink.flush();
+	 * @endcode
+	 */
+	class async_sink
+	{
+	public:
+		// Number of bytes available for the format string and values of a message
+		static constexpr std::size_t record_capacity = 224;
+
+	private:
+		struct slot
+		{
+			std::atomic<std::size_t> sequence{ 0 };
+			bool (* consume)(void*, memory_buffer&) = nullptr;
+			alignas(std::max_align_t) unsigned char storage[record_capacity];
+		};
+
+		// Chunk size written to the file descriptor at once
+		static constexpr std::size_t write_threshold = 16384;
+
+		int const fd;
+		queue_full_policy const policy;
+		std::size_t const mask;
+		std::unique_ptr<slot[]> slots;
+
+		alignas(64) std::atomic<std::size_t> enqueue_position{ 0 };
+		alignas(64) std::atomic<std::size_t> written_position{ 0 };
+		std::atomic<std::size_t> dropped_count{ 0 };
+		std::atomic<std::size_t> failed_count{ 0 };
+		std::atomic<bool> stopping{ false };
+
+		std::thread worker;
+
+
+		static std::size_t round_up_to_power_of_two(std::size_t value)
+		{
+			std::size_t result = 2;
+			while (result < value)
+			{
+				result *= 2;
+			}
+			return result;
+		}
+
+
+		// Claim the next free slot and store its position. Returns false if the
+		// ring buffer is full and messages are dropped.
+		bool claim(std::size_t& position)
+		{
+			position = enqueue_position.load(std::memory_order_relaxed);
+
+			for (;;)
+			{
+				slot& current = slots[position & mask];
+				auto const sequence = current.sequence.load(std::memory_order_acquire);
+				auto const difference = std::ptrdiff_t(sequence - position);
+
+				if (difference == 0)
+				{
+					if (enqueue_position.compare_exchange_weak(position, position + 1,
+							std::memory_order_relaxed))
+					{
+						return true;
+					}
+				}
+				else if (difference < 0)
+				{
+					// The slot still holds the message from one round before: full.
+					if (policy == queue_full_policy::drop)
+					{
+						dropped_count.fetch_add(1, std::memory_order_relaxed);
+						return false;
+					}
+
+					std::this_thread::yield();
+					position = enqueue_position.load(std::memory_order_relaxed);
+				}
+				else
+				{
+					position = enqueue_position.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+
+		template<typename FormatT, typename... ValueTs>
+		bool enqueue(FormatT format_str, ValueTs&& ... values)
+		{
+			using record = internal::async_record<FormatT, internal::async_value_t<ValueTs>...>;
+
+			static_assert(sizeof(record) <= record_capacity,
+					"The values of a message do not fit into async_sink::record_capacity bytes");
+			static_assert(alignof(record) <= alignof(std::max_align_t),
+					"The values of a message need a larger alignment than async_sink supports");
+
+			std::size_t position;
+			if (!claim(position))
+			{
+				return false;
+			}
+
+			slot& current = slots[position & mask];
+
+#ifdef FLOSSY_NO_EXCEPTIONS
+			new(current.storage) record{ format_str,
+					std::tuple<internal::async_value_t<ValueTs>...>(std::forward<ValueTs>(values)...) };
+			current.consume = &record::consume;
+#else
+			try
+			{
+				new(current.storage) record{ format_str,
+						std::tuple<internal::async_value_t<ValueTs>...>(std::forward<ValueTs>(values)...) };
+				current.consume = &record::consume;
+			}
+			catch (...)
+			{
+				// The slot is claimed already. It has to be published, or the
+				// background thread waits for it forever.
+				current.consume = &discard;
+				current.sequence.store(position + 1, std::memory_order_release);
+				throw;
+			}
+#endif
+
+			current.sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+
+		// Stands in for a message whose values could not be copied
+		static bool discard(void*, memory_buffer&)
+		{
+			return false;
+		}
+
+
+		// Body of the background thread
+		void run()
+		{
+			memory_buffer buffer;
+			std::size_t position = 0;
+			int idle_rounds = 0;
+
+			for (;;)
+			{
+				slot& current = slots[position & mask];
+
+				if (current.sequence.load(std::memory_order_acquire) == position + 1)
+				{
+					if (!current.consume(current.storage, buffer))
+					{
+						failed_count.fetch_add(1, std::memory_order_relaxed);
+					}
+					current.sequence.store(position + mask + 1, std::memory_order_release);
+					++position;
+					idle_rounds = 0;
+
+					if (buffer.size() >= write_threshold)
+					{
+						write(buffer);
+						written_position.store(position, std::memory_order_release);
+					}
+					continue;
+				}
+
+				// Nothing to take out: write what was collected so far.
+				if (!buffer.empty())
+				{
+					write(buffer);
+				}
+				written_position.store(position, std::memory_order_release);
+
+				if (stopping.load(std::memory_order_acquire)
+					&& enqueue_position.load(std::memory_order_acquire) == position)
+				{
+					return;
+				}
+
+				// Spin shortly for the next message, then sleep to free the CPU.
+				if (++idle_rounds < 64)
+				{
+					std::this_thread::yield();
+				}
+				else
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+				}
+			}
+		}
+
+
+		void write(memory_buffer& buffer)
+		{
+			if (!internal::write_all(fd, buffer.data(), buffer.size()))
+			{
+				failed_count.fetch_add(1, std::memory_order_relaxed);
+			}
+			buffer.clear();
+		}
+
+	public:
+		/**
+		 * @param fd File descriptor to write to. It is not closed by the sink.
+		 * @param capacity Number of messages the ring buffer holds, rounded up
+		 * to a power of two.
+		 * @param policy What format does if the ring buffer is full.
+		 */
+		explicit async_sink(int fd, std::size_t capacity = 1024,
+				queue_full_policy policy = queue_full_policy::block)
+				: fd(fd), policy(policy), mask(round_up_to_power_of_two(capacity) - 1),
+				  slots(new slot[mask + 1])
+		{
+			for (std::size_t i = 0; i <= mask; ++i)
+			{
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+
+			worker = std::thread([this]
+			{
+				run();
+			});
+		}
+
+		async_sink(async_sink const&) = delete;
+		async_sink& operator=(async_sink const&) = delete;
+
+		// Writes all remaining messages and stops the background thread.
+		~async_sink()
+		{
+			stopping.store(true, std::memory_order_release);
+			worker.join();
+		}
+
+
+		/**
+		 * Queue a message for formatting on the background thread.
+		 *
+		 * @param format_str Format string. Only the pointer is stored, so it
+		 * must outlive the sink, like string literals do.
+		 * @param values The values to be formatted. They are copied.
+		 *
+		 * @return False if the message was dropped, because the ring buffer
+		 * was full.
+		 */
+		template<typename... ValueTs>
+		bool format(char const* format_str, ValueTs&& ... values)
+		{
+			return enqueue(format_str, std::forward<ValueTs>(values)...);
+		}
+
+
+		// Overload of format for compiled (FLOSSY_FMT) format strings.
+		template<typename S, typename... ValueTs,
+				typename = std::enable_if_t<internal::is_compiled_string<S>>>
+		bool format(S const& format_str, ValueTs&& ... values)
+		{
+			return enqueue(format_str, std::forward<ValueTs>(values)...);
+		}
+
+
+		// Wait until all messages queued before have been written.
+		void flush()
+		{
+			auto const target = enqueue_position.load(std::memory_order_acquire);
+			while (written_position.load(std::memory_order_acquire) < target)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+
+
+		// Number of messages dropped, because the ring buffer was full.
+		std::size_t dropped() const noexcept
+		{
+			return dropped_count.load(std::memory_order_relaxed);
+		}
+
+
+		// Number of messages that could not be formatted (invalid format
+		// strings or values that threw while being copied or formatted) and
+		// writes to the file descriptor that failed.
+		std::size_t failed() const noexcept
+		{
+			return failed_count.load(std::memory_order_relaxed);
+		}
+	};
+
+}
+
+#endif
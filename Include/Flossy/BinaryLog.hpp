@@ -0,0 +1,675 @@
+/*
+    flossy 1.0
+
+    This project is free software; you can redistribute it and/or modify it
+    under the terms of the MIT license:
+
+    Copyright (c) 2016 Florian Kesseler
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+*/
+
+
+/*
+  Deferred formatting for the most frequent messages: instead of formatting
+  the values, binary_writer stores an identifier of the format string and the
+  raw bytes of the values in a compact binary stream. binary_reader (and the
+  flossy-decode tool built on it) turns that stream into text later, with the
+  same formatting functions format uses, so the output is the same as if the
+  messages had been formatted directly.
+
+    flossy::binary_writer log(fd);
+    log.format("request {} took {.1f} us\n", id, duration);
+
+  $ flossy-decode trace.bin > trace.txt
+
+  Format strings are identified by their address. They must be string
+  literals (or otherwise outlive the writer) or FLOSSY_FMT strings, and are
+  written to the stream once, the first time they are used. Values can be
+  integers, bool, floats, C strings, strings and string views (which are
+  copied); custom types are not supported. Writing a message neither formats
+  nor allocates memory; the records are collected in a buffer that is written
+  to the file descriptor when it is full, on flush() and by the destructor.
+
+  The stream is written in the byte order and with the long double size of
+  the writing machine. binary_reader refuses streams from machines that
+  differ in these.
+
+  Stream layout:
+    header:  'F' 'L' 'B' '1', byte order (0 little, 1 big endian),
+             sizeof(long double)
+    format:  'F', uint32 id, uint32 length, characters
+    message: 'M', uint32 id, uint8 value count, values
+    value:   uint8 type, raw bytes of the value
+             (strings: uint32 length, characters)
+*/
+
+
+#ifndef FLOSSY_BINARY_LOG_H_INCLUDED
+#define FLOSSY_BINARY_LOG_H_INCLUDED
+
+#include "Flossy/Flossy.hpp"
+#include "Flossy/FileDescriptor.hpp"
+
+#include <unordered_map>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace flossy
+{
+	namespace internal
+	{
+		// Type of a value in a message record
+		enum class binary_type : unsigned char
+		{
+			int8 = 1,
+			int16,
+			int32,
+			int64,
+			uint8,
+			uint16,
+			uint32,
+			uint64,
+			boolean,
+			float32,
+			float64,
+			long_double,
+			string
+		};
+
+		constexpr char binary_log_magic[4] = { 'F', 'L', 'B', '1' };
+		constexpr char binary_format_record = 'F';
+		constexpr char binary_message_record = 'M';
+		constexpr std::size_t binary_header_size = sizeof(binary_log_magic) + 2;
+
+
+		inline unsigned char binary_byte_order()
+		{
+			std::uint16_t const value = 1;
+			unsigned char first;
+			std::memcpy(&first, &value, 1);
+			return first == 1 ? 0 : 1;
+		}
+
+
+		// Values stored as strings: their characters are copied into the record.
+		template<typename ValueT, typename DecayedT = std::decay_t<ValueT>>
+		constexpr bool is_binary_string = std::is_same<DecayedT, char const*>::value
+										  || std::is_same<DecayedT, char*>::value
+										  || std::is_same<DecayedT, std::string>::value
+										  || std::is_same<DecayedT, std::string_view>::value;
+
+
+		// Type tag of a value that is not a string
+		template<typename ValueT>
+		constexpr binary_type binary_type_of()
+		{
+			static_assert(std::is_arithmetic<ValueT>::value,
+					"binary_writer only supports integers, floats and strings");
+
+			if constexpr (std::is_same<ValueT, bool>::value)
+			{
+				return binary_type::boolean;
+			}
+			else if constexpr (std::is_same<ValueT, float>::value)
+			{
+				return binary_type::float32;
+			}
+			else if constexpr (std::is_same<ValueT, double>::value)
+			{
+				return binary_type::float64;
+			}
+			else if constexpr (std::is_same<ValueT, long double>::value)
+			{
+				return binary_type::long_double;
+			}
+			else
+			{
+				// Integers are stored with their size and signedness, as both show
+				// in hexadecimal output of negative values.
+				int const size_index = sizeof(ValueT) == 1 ? 0 : sizeof(ValueT) == 2 ? 1 : sizeof(ValueT) == 4 ? 2 : 3;
+				return binary_type(int(std::is_signed<ValueT>::value ? binary_type::int8 : binary_type::uint8)
+								   + size_index);
+			}
+		}
+
+
+		// A value read from a message record. Strings refer to the record.
+		struct binary_value
+		{
+			binary_type type;
+
+			union
+			{
+				std::int8_t int8;
+				std::int16_t int16;
+				std::int32_t int32;
+				std::int64_t int64;
+				std::uint8_t uint8;
+				std::uint16_t uint16;
+				std::uint32_t uint32;
+				std::uint64_t uint64;
+				bool boolean;
+				float float32;
+				double float64;
+				long double long_double;
+			};
+
+			std::string_view string;
+		};
+
+
+		// Reads from the bytes of a binary stream. All reads fail once one did
+		// not find enough bytes left, which means the record is incomplete.
+		class binary_cursor
+		{
+			char const* position;
+			char const* const end;
+			bool complete = true;
+
+		public:
+			binary_cursor(char const* start, char const* end)
+					: position(start), end(end)
+			{
+			}
+
+			bool read(void* destination, std::size_t size)
+			{
+				if (!complete || std::size_t(end - position) < size)
+				{
+					complete = false;
+					return false;
+				}
+				std::memcpy(destination, position, size);
+				position += size;
+				return true;
+			}
+
+			// Characters of the given length, referring to the stream
+			bool read_string(std::string_view& destination)
+			{
+				std::uint32_t size = 0;
+				if (!read(&size, sizeof(size)) || std::size_t(end - position) < size)
+				{
+					complete = false;
+					return false;
+				}
+				destination = std::string_view(position, size);
+				position += size;
+				return true;
+			}
+
+			char const* current() const noexcept
+			{
+				return position;
+			}
+		};
+	}
+
+
+	/**
+	 * @page Binary Log Writer.
+	 *
+	 * Writes messages as binary records, to be formatted later by
+	 * binary_reader or the flossy-decode tool. See the description at the
+	 * top of this file. A writer must only be used by one thread at a time.
+	 *
+	 * @example
+	 * @code
+	 * flossy::binary_writer log(fd);
+	 * log.format("request {} took {.1f} us\n", id, duration);
+	 * log.flush();
+	 * @endcode
+	 */
+	class binary_writer
+	{
+		// Number of format strings whose identifiers are remembered. Once the
+		// table is full, further format strings are written again with every
+		// message.
+		static constexpr std::size_t format_table_size = 1024;
+
+		// Number of table entries looked at to find a format string
+		static constexpr std::size_t format_table_probes = 16;
+
+		int const fd;
+		std::size_t const capacity;
+		std::unique_ptr<char[]> buffer;
+		std::size_t used = 0;
+		std::size_t failed_count = 0;
+		std::uint32_t next_id = 0;
+
+		std::array<char const*, format_table_size> format_strings{};
+		std::array<std::uint32_t, format_table_size> format_ids{};
+
+
+		void put(void const* data, std::size_t size)
+		{
+			if (size <= capacity - used)
+			{
+				std::memcpy(buffer.get() + used, data, size);
+				used += size;
+				return;
+			}
+
+			// Does not fit, write out the buffer (repeatedly for huge strings)
+			auto const* bytes = static_cast<char const*>(data);
+			while (size > 0)
+			{
+				if (used == capacity)
+				{
+					flush();
+				}
+				std::size_t const count = std::min(size, capacity - used);
+				std::memcpy(buffer.get() + used, bytes, count);
+				used += count;
+				bytes += count;
+				size -= count;
+			}
+		}
+
+
+		template<typename ValueT>
+		void put_value(ValueT const& value)
+		{
+			put(&value, sizeof(value));
+		}
+
+
+		void put_string(std::string_view value)
+		{
+			put_value(internal::binary_type::string);
+			put_value(std::uint32_t(value.size()));
+			put(value.data(), value.size());
+		}
+
+
+		// Write a format record, returns the new identifier.
+		std::uint32_t define(std::string_view format_str)
+		{
+			std::uint32_t const id = next_id++;
+			put_value(internal::binary_format_record);
+			put_value(id);
+			put_value(std::uint32_t(format_str.size()));
+			put(format_str.data(), format_str.size());
+			return id;
+		}
+
+
+		// Identifier of the format string. The format record is written the
+		// first time it is used; its length is only determined then.
+		template<typename ViewFunc>
+		std::uint32_t format_id(char const* format_str, ViewFunc const& view)
+		{
+			auto const address = std::uintptr_t(format_str);
+			std::size_t const start = std::size_t((address >> 3U) ^ (address >> 13U));
+
+			for (std::size_t probe = 0; probe < format_table_probes; ++probe)
+			{
+				std::size_t const index = (start + probe) % format_table_size;
+
+				if (format_strings[index] == format_str)
+				{
+					return format_ids[index];
+				}
+				if (format_strings[index] == nullptr)
+				{
+					format_strings[index] = format_str;
+					return format_ids[index] = define(view());
+				}
+			}
+
+			return define(view());
+		}
+
+
+		template<typename... ValueTs>
+		void write_message(std::uint32_t id, ValueTs const& ... values)
+		{
+			static_assert(sizeof...(ValueTs) < 256, "binary_writer supports up to 255 values per message");
+
+			put_value(internal::binary_message_record);
+			put_value(id);
+			put_value(std::uint8_t(sizeof...(ValueTs)));
+			(write_value(values), ...);
+		}
+
+
+		template<typename ValueT>
+		void write_value(ValueT const& value)
+		{
+			if constexpr (internal::is_binary_string<ValueT>)
+			{
+				put_string(std::string_view(value));
+			}
+			else
+			{
+				put_value(internal::binary_type_of<ValueT>());
+				put_value(value);
+			}
+		}
+
+	public:
+		/**
+		 * @param fd File descriptor to write to. It is not closed by the writer.
+		 * @param capacity Size of the buffer collecting the records.
+		 */
+		explicit binary_writer(int fd, std::size_t capacity = 65536)
+				: fd(fd), capacity(std::max<std::size_t>(capacity, 64)), buffer(new char[this->capacity])
+		{
+			put(internal::binary_log_magic, sizeof(internal::binary_log_magic));
+			put_value(internal::binary_byte_order());
+			put_value(std::uint8_t(sizeof(long double)));
+		}
+
+		binary_writer(binary_writer const&) = delete;
+		binary_writer& operator=(binary_writer const&) = delete;
+
+		// Writes the remaining records.
+		~binary_writer()
+		{
+			flush();
+		}
+
+
+		/**
+		 * Write a message record.
+		 *
+		 * @param format_str Format string. Only its address is stored with the
+		 * message, so it must outlive the writer, like string literals do.
+		 * @param values The values to be formatted later.
+		 */
+		template<typename... ValueTs>
+		void format(char const* format_str, ValueTs const& ... values)
+		{
+			write_message(format_id(format_str, [&]
+			{
+				return std::string_view(format_str);
+			}), values...);
+		}
+
+
+		// Overload of format for compiled (FLOSSY_FMT) format strings.
+		template<typename S, typename... ValueTs,
+				typename = std::enable_if_t<internal::is_compiled_string<S>>>
+		void format(S const&, ValueTs const& ... values)
+		{
+			static_assert(internal::compiled_format<S>::placeholders == sizeof...(ValueTs),
+					"The number of placeholders does not match the number of values");
+
+			constexpr auto text = S::value();
+			write_message(format_id(text.data(), [&]
+			{
+				return text;
+			}), values...);
+		}
+
+
+		// Write the collected records to the file descriptor.
+		void flush()
+		{
+			if (used > 0 && !internal::write_all(fd, buffer.get(), used))
+			{
+				++failed_count;
+			}
+			used = 0;
+		}
+
+
+		// Number of writes to the file descriptor that failed.
+		std::size_t failed() const noexcept
+		{
+			return failed_count;
+		}
+	};
+
+
+	/**
+	 * @page Binary Log Reader.
+	 *
+	 * Formats the messages of a stream written by binary_writer. The stream
+	 * can be passed in pieces of any size: decode formats all complete
+	 * records and leaves the rest for the next call.
+	 *
+	 * @example
+	 * @code
+	 * flossy::binary_reader reader;
+	 * std::string text;
+	 * std::string_view bytes = stream;
+	 * reader.decode(std::back_inserter(text), bytes);
+	 * @endcode
+	 */
+	class binary_reader
+	{
+		std::unordered_map<std::uint32_t, std::string> formats;
+		bool header_read = false;
+		std::vector<internal::binary_value> values;
+
+
+		[[noreturn]] static void invalid(char const* message)
+		{
+			internal::raise_error(message);
+		}
+
+
+		// Read the values of a message. Returns false if it is incomplete.
+		bool read_values(internal::binary_cursor& cursor, std::size_t count)
+		{
+			values.resize(count);
+
+			for (auto& value : values)
+			{
+				if (!cursor.read(&value.type, sizeof(value.type)))
+				{
+					return false;
+				}
+
+				bool complete;
+				switch (value.type)
+				{
+				case internal::binary_type::int8:
+					complete = cursor.read(&value.int8, sizeof(value.int8));
+					break;
+				case internal::binary_type::int16:
+					complete = cursor.read(&value.int16, sizeof(value.int16));
+					break;
+				case internal::binary_type::int32:
+					complete = cursor.read(&value.int32, sizeof(value.int32));
+					break;
+				case internal::binary_type::int64:
+					complete = cursor.read(&value.int64, sizeof(value.int64));
+					break;
+				case internal::binary_type::uint8:
+					complete = cursor.read(&value.uint8, sizeof(value.uint8));
+					break;
+				case internal::binary_type::uint16:
+					complete = cursor.read(&value.uint16, sizeof(value.uint16));
+					break;
+				case internal::binary_type::uint32:
+					complete = cursor.read(&value.uint32, sizeof(value.uint32));
+					break;
+				case internal::binary_type::uint64:
+					complete = cursor.read(&value.uint64, sizeof(value.uint64));
+					break;
+				case internal::binary_type::boolean:
+					complete = cursor.read(&value.boolean, sizeof(value.boolean));
+					break;
+				case internal::binary_type::float32:
+					complete = cursor.read(&value.float32, sizeof(value.float32));
+					break;
+				case internal::binary_type::float64:
+					complete = cursor.read(&value.float64, sizeof(value.float64));
+					break;
+				case internal::binary_type::long_double:
+					complete = cursor.read(&value.long_double, sizeof(value.long_double));
+					break;
+				case internal::binary_type::string:
+					complete = cursor.read_string(value.string);
+					break;
+				default:
+					invalid("Invalid value type in binary log");
+				}
+
+				if (!complete)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+
+		// Format the message with the values read before
+		template<typename OutIt>
+		OutIt format_message(OutIt out, std::string const& format_str) const
+		{
+			std::vector<format_arg<char, OutIt>> args;
+			args.reserve(values.size());
+
+			for (auto const& value : values)
+			{
+				switch (value.type)
+				{
+				case internal::binary_type::int8:
+					args.emplace_back(value.int8);
+					break;
+				case internal::binary_type::int16:
+					args.emplace_back(value.int16);
+					break;
+				case internal::binary_type::int32:
+					args.emplace_back(value.int32);
+					break;
+				case internal::binary_type::int64:
+					args.emplace_back(value.int64);
+					break;
+				case internal::binary_type::uint8:
+					args.emplace_back(value.uint8);
+					break;
+				case internal::binary_type::uint16:
+					args.emplace_back(value.uint16);
+					break;
+				case internal::binary_type::uint32:
+					args.emplace_back(value.uint32);
+					break;
+				case internal::binary_type::uint64:
+					args.emplace_back(value.uint64);
+					break;
+				case internal::binary_type::boolean:
+					args.emplace_back(value.boolean);
+					break;
+				case internal::binary_type::float32:
+					args.emplace_back(value.float32);
+					break;
+				case internal::binary_type::float64:
+					args.emplace_back(value.float64);
+					break;
+				case internal::binary_type::long_double:
+					args.emplace_back(value.long_double);
+					break;
+				default:
+					args.emplace_back(value.string);
+					break;
+				}
+			}
+
+			return vformat(out, std::string_view(format_str),
+					format_args<char, OutIt>(args.data(), args.size()));
+		}
+
+	public:
+		/**
+		 * Format the complete records at the start of bytes to out.
+		 *
+		 * @param out Output iterator to store the resulting characters.
+		 * @param bytes The stream. Advanced past the records read, so it holds
+		 * the start of an incomplete record afterwards, if any.
+		 *
+		 * @return Updated 'out' iterator.
+		 */
+		template<typename OutIt>
+		OutIt decode(OutIt out, std::string_view& bytes)
+		{
+			if (!header_read)
+			{
+				if (bytes.size() < internal::binary_header_size)
+				{
+					return out;
+				}
+				if (bytes.compare(0, sizeof(internal::binary_log_magic),
+						std::string_view(internal::binary_log_magic, sizeof(internal::binary_log_magic))) != 0)
+				{
+					invalid("Not a flossy binary log");
+				}
+				if ((unsigned char) bytes[4] != internal::binary_byte_order()
+					|| (unsigned char) bytes[5] != sizeof(long double))
+				{
+					invalid("Binary log written on an incompatible machine");
+				}
+				bytes.remove_prefix(internal::binary_header_size);
+				header_read = true;
+			}
+
+			while (!bytes.empty())
+			{
+				internal::binary_cursor cursor(bytes.data(), bytes.data() + bytes.size());
+				char kind = 0;
+				std::uint32_t id = 0;
+				cursor.read(&kind, sizeof(kind));
+
+				if (kind == internal::binary_format_record)
+				{
+					std::string_view format_str;
+					if (!cursor.read(&id, sizeof(id)) || !cursor.read_string(format_str))
+					{
+						break;
+					}
+					formats[id] = std::string(format_str);
+				}
+				else if (kind == internal::binary_message_record)
+				{
+					std::uint8_t count = 0;
+					if (!cursor.read(&id, sizeof(id)) || !cursor.read(&count, sizeof(count))
+						|| !read_values(cursor, count))
+					{
+						break;
+					}
+
+					auto const format_str = formats.find(id);
+					if (format_str == formats.end())
+					{
+						invalid("Unknown format string in binary log");
+					}
+					out = format_message(out, format_str->second);
+				}
+				else
+				{
+					invalid("Invalid record in binary log");
+				}
+
+				bytes.remove_prefix(std::size_t(cursor.current() - bytes.data()));
+			}
+
+			return out;
+		}
+	};
+
+}
+
+#endif
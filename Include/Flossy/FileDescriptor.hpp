@@ -0,0 +1,80 @@
+/*
+    flossy 1.0
+
+    This project is free software; you can redistribute it and/or modify it
+    under the terms of the MIT license:
+
+    Copyright (c) 2016 Florian Kesseler
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+*/
+
+
+/*
+  Output to file descriptors, shared by the optional parts of flossy writing
+  to them (AsyncSink.hpp and BinaryLog.hpp).
+*/
+
+
+#ifndef FLOSSY_FILE_DESCRIPTOR_H_INCLUDED
+#define FLOSSY_FILE_DESCRIPTOR_H_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <cerrno>
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+namespace flossy
+{
+	namespace internal
+	{
+		// Write all characters to the file descriptor, retrying after
+		// interruptions and partial writes. Returns false on errors.
+		inline bool write_all(int fd, char const* data, std::size_t size)
+		{
+			while (size > 0)
+			{
+#ifdef _WIN32
+				auto const written = ::_write(fd, data, unsigned(std::min<std::size_t>(size, 1U << 30U)));
+#else
+				auto const written = ::write(fd, data, size);
+#endif
+				if (written < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+					return false;
+				}
+
+				data += written;
+				size -= std::size_t(written);
+			}
+			return true;
+		}
+	}
+}
+
+#endif
@@ -116,7 +116,7 @@
   sign: '+' | ' ' | '-'
   width: integer
   precision: integer
-  type: 'd', 'o', 'x', 'f', 'e', 's', 'b'
+  type: 'd', 'o', 'x', 'f', 'e', 'r', 's', 'b'
 
   'align' specifies where in the resulting field the value will be aligned, as
   described in the following table:
@@ -151,10 +151,11 @@
 
   'width' specifies the minimum width of the field. If this is larger than the
   width of the converted value, the value will be aligned and padded according
-  to the 'align' and 'zero' flags.
+  to the 'align' and 'zero' flags. Widths and precisions larger than 32767 are
+  clamped to it.
 
   'precision' specifies the number of digits in the fractional part of floating
-  point numbers.
+  point numbers. It defaults to 6.
 
   'type' specifies the formatting method used. This is basically used to change
   the display type of numbers, like the number base or float representation
@@ -162,7 +163,10 @@
   field currently converted.
 
   The values have the same meaning as in printf, with the addition of 'b',
-  which outputs an integer in binary form.
+  which outputs an integer in binary form, and 'r', which outputs a float in
+  the shortest representation that reads back to the same value. Like
+  std::to_chars, 'r' uses fixed notation unless scientific notation is
+  shorter, and ignores the precision.
 
 
 5. User Defined Types
@@ -193,9 +197,167 @@
   characters, and strings to built upon.
 
   conversion_options is holds the format flags specified in the format string.
-  See definition of conversion_options for more information.
+  See definition of conversion_options for more information. It is 8 bytes
+  large, so take it by value. options.is_default() is true for a plain '{}',
+  where most formatters can skip padding and sign handling.
 
   There is currently no way to add your own conversion flags or options, sorry.
+
+
+6. Compiled Format Strings
+
+  Format strings known at compile time can be wrapped in FLOSSY_FMT. They are
+  parsed by the compiler into a sequence of literal text and conversion
+  specifiers, so formatting does no parsing at all. An invalid format string
+  and a number of values different from the number of placeholders are
+  reported as compile errors:
+
+    auto result = format(FLOSSY_FMT("The first value passed is {}"
+                                    ", and the second is {}!"), 42, "foo");
+
+  Compiled format strings are accepted by all format and format_it overloads
+  in place of the format string (or the start and end iterators).
+
+  With integers, characters and strings as values, a compiled format string
+  can be formatted at compile time by static_format. The result holds up to
+  the given number of characters and converts to a string view:
+
+    constexpr auto banner = static_format<32>(FLOSSY_FMT("{} {}.{}"), "flossy", 1, 0);
+
+
+7. Parsed Format Strings
+
+  Format strings only known at runtime can be parsed once into a
+  parsed_format object and then be used for formatting many times:
+
+    flossy::parsed_format<char> const format_str(message_template);
+    auto result = format(format_str, 42, "foo");
+
+  The constructor validates the whole format string and throws
+  std::invalid_argument if it is invalid. Like compiled format strings,
+  parsed format strings are accepted by all format and format_it overloads.
+
+  The number of values can be given as second template argument. The
+  constructor then also rejects format strings with a different number of
+  placeholders, passing a different number of values is a compile error,
+  and formatting skips all checks. Created from a FLOSSY_FMT string, the
+  placeholders are counted at compile time:
+
+    flossy::parsed_format<char, 2> const checked(message_template);
+    flossy::parsed_format<char, 2> const compiled(FLOSSY_FMT("{} and {}"));
+
+  Only FLOSSY_FMT strings and parsed_format objects with a number of values
+  check the number of values. Format strings given as strings, string views
+  or parsed_format objects without a number of values are not checked:
+  placeholders following the last value are copied verbatim, and values
+  without a placeholder are ignored.
+
+
+8. Formatted Size
+
+  std::size_t formatted_size(format_str, ValueTs const&... elements)
+
+  Returns the number of characters format would produce for the given
+  format string and values, without producing them. Integers, characters
+  and strings are measured without converting them. format uses this to
+  allocate the resulting string only once if all values are of these types.
+
+
+9. Formatting to a Fixed-Size Buffer
+
+  format_to_n_result format_to_n(CharT* buffer, std::size_t buffer_size,
+                                 format_str, ValueTs const&... elements)
+
+  Writes at most buffer_size characters to buffer and returns the number of
+  characters written and the size of the complete output. Does not allocate
+  memory for integers, characters and strings, and stops converting values
+  once the buffer is full.
+
+
+10. Type-Erased Formatting
+
+  OutIt vformat(OutIt out, std::basic_string_view<CharT> format_str,
+                format_args<CharT, OutIt> const& args)
+
+  Works like format_it, but takes the values packed into a small array by
+  make_format_args<CharT, OutIt>(values...). Integers, floats and strings are
+  stored by value, other types as a pointer and a function calling their
+  format_element. The formatting loop is therefore compiled once per
+  character and output iterator type, instead of once per combination of
+  value types. format, formatted_size and format_to_n use it for format
+  strings given as strings.
+
+    std::string result;
+    using OutIt = std::back_insert_iterator<std::string>;
+    vformat(std::back_inserter(result), "The first value passed is {}",
+            make_format_args<char, OutIt>(42));
+
+
+11. Memory Buffers
+
+  basic_memory_buffer<CharT, InlineN> (memory_buffer for char) holds up to
+  InlineN (default 500) characters without allocating memory, and keeps its
+  memory when cleared, so it can be reused for many formatting calls.
+
+  std::basic_string_view<CharT> format_to(basic_memory_buffer<CharT, InlineN>& buffer,
+                                          format_str, ValueTs const&... elements)
+
+  Appends the formatted output to the buffer and returns the appended
+  characters. A back_inserter of the buffer can also be passed to format_it.
+
+    flossy::memory_buffer buffer;
+    flossy::format_to(buffer, "The first value passed is {}", 42);
+    std::string_view const text = buffer.view();
+
+
+12. Allocators
+
+  format(std::allocator_arg, allocator, format_str, ValueTs&&... elements)
+  format(std::pmr::memory_resource* resource, format_str, ValueTs&&... elements)
+
+  Create the resulting string with the given allocator, or as a std::pmr
+  string using the given memory resource. Formatting itself does not
+  allocate memory, except for floats with very long output.
+
+
+13. Statistics
+
+  std::vector<format_stats> stats_snapshot()
+  void stats_dump(std::ostream& out)
+  void stats_reset()
+  void stats_count_allocation()
+
+  Only with FLOSSY_ENABLE_STATS defined: format, format_to and format_to_n
+  record per format string the number of calls, bytes produced,
+  placeholders, heap allocations (counted by calling stats_count_allocation
+  from operator new) and the time and cycles spent. Threads count
+  separately, stats_snapshot sums them up. Without FLOSSY_ENABLE_STATS
+  nothing is recorded.
+
+    flossy::stats_dump(std::cerr);
+
+
+14. Errors and Builds Without Exceptions
+
+  format_status check_format(format_str)
+  try_format_result<OutIt> try_format_to(OutIt out, format_str, ValueTs const&... elements)
+  format_status try_format_to(basic_memory_buffer<CharT, InlineN>& buffer, format_str,
+                              ValueTs const&... elements)
+
+  Invalid format strings make the other functions throw
+  std::invalid_argument. check_format and try_format_to report them by a
+  format_status instead: the kind of error and its offset in the format
+  string. try_format_to checks the format string as far as it is used and
+  only formats if it is valid.
+
+  With exceptions disabled (-fno-exceptions, or FLOSSY_NO_EXCEPTIONS
+  defined), flossy contains no throw expressions and the other functions
+  abort for invalid format strings, so runtime format strings should go
+  through check_format or try_format_to.
+
+    auto const result = flossy::try_format_to(std::back_inserter(text), format_str, 42);
+    if (!result.status)
+      report(result.status.message(), result.status.offset);
 */
 
 
@@ -203,24 +365,83 @@
 #define FLOSSY_H_INCLUDED
 
 
-#ifndef FLOSSY_FLOAT_METHOD
-# define FLOSSY_FLOAT_METHOD FLOSSY_FLOAT_METHOD_SSTREAM
-#endif
-
-#define FLOSSY_FLOAT_METHOD_SSTREAM 0
-#define FLOSSY_FLOAT_METHOD_FAST    1 // not implemented, yet
-#define FLOSSY_FLOAT_METHOD_GRISU   2 // not implemented, yet
+#define FLOSSY_FLOAT_METHOD_SSTREAM  0
+#define FLOSSY_FLOAT_METHOD_FAST     1
+#define FLOSSY_FLOAT_METHOD_GRISU    2
+#define FLOSSY_FLOAT_METHOD_TO_CHARS 3
 
 #include <string_view>
+#include <type_traits>
 #include <exception>
 #include <algorithm>
 #include <iterator>
+#include <charconv>
 #include <sstream>
+#include <utility>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <vector>
+#include <tuple>
 #include <cmath>
 #include <array>
+#include <new>
+
+#if __has_include(<memory_resource>)
+# include <memory_resource>
+#endif
+
+// SSE2 is used to speed up some conversions. Define FLOSSY_NO_SIMD to only use
+// portable code.
+#if !defined(FLOSSY_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+# define FLOSSY_SSE2 1
+# include <emmintrin.h>
+#endif
+
+// AVX2 is used in addition to SSE2 if the compiler targets it (e.g. -mavx2).
+#if defined(FLOSSY_SSE2) && defined(__AVX2__)
+# define FLOSSY_AVX2 1
+# include <immintrin.h>
+#endif
+
+// Statistics of the format calls per format string, see stats_snapshot.
+#ifdef FLOSSY_ENABLE_STATS
+# include <unordered_map>
+# include <ostream>
+# include <iomanip>
+# include <chrono>
+# include <deque>
+# include <mutex>
+# if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#  define FLOSSY_HAS_RDTSC 1
+# elif defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#  define FLOSSY_HAS_RDTSC 1
+# endif
+#endif
+
+// Without exceptions (-fno-exceptions or FLOSSY_NO_EXCEPTIONS defined), invalid
+// format strings abort instead of throwing, see check_format and try_format_to.
+#if !defined(FLOSSY_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) \
+	&& !defined(_CPPUNWIND)
+# define FLOSSY_NO_EXCEPTIONS 1
+#endif
+
+#ifdef FLOSSY_NO_EXCEPTIONS
+# include <cstdlib>
+#else
+# include <stdexcept>
+#endif
+
+// Use std::to_chars for floats where the standard library supports it.
+#ifndef FLOSSY_FLOAT_METHOD
+# ifdef __cpp_lib_to_chars
+#  define FLOSSY_FLOAT_METHOD FLOSSY_FLOAT_METHOD_TO_CHARS
+# else
+#  define FLOSSY_FLOAT_METHOD FLOSSY_FLOAT_METHOD_SSTREAM
+# endif
+#endif
 
 namespace flossy
 {
@@ -234,869 +455,5265 @@ namespace flossy
 		return 2021.1f;
 	}
 
-	namespace internal
+
+	/**
+	 * @page Memory Buffers.
+	 *
+	 * A growable character buffer that keeps up to InlineN characters in the
+	 * object itself and only allocates memory if more are appended. Meant as a
+	 * reusable target for formatting short messages: clearing it keeps the
+	 * allocated memory, so formatting into the same buffer again does not
+	 * allocate either.
+	 *
+	 * Use format_to to append formatted output, or a back_inserter of the
+	 * buffer with format_it. The content is available as a string_view.
+	 *
+	 * @example
+	 * @code
+	 * flossy::memory_buffer buffer;
+	 * flossy::format_to(buffer, "The first value passed is {}", 42);
+	 * write_log(buffer.view());
+	 * buffer.clear();
+	 * @endcode
+	 *
+	 * @tparam CharT Character type of the buffer.
+	 * @tparam InlineN Number of characters that fit into the buffer without
+	 * allocating memory.
+	 */
+	template<typename CharT, std::size_t InlineN = 500>
+	class basic_memory_buffer
 	{
+		std::array<CharT, InlineN> inline_storage;
+		std::unique_ptr<CharT[]> heap_storage;
+		CharT* storage = inline_storage.data();
+		std::size_t length = 0;
+		std::size_t storage_capacity = InlineN;
 
-		// Used only for types that allow different representations, i.e. not for
-		// strings.
-		enum class conversion_format
+
+		// Make room for at least the given number of characters. Grows by half
+		// the capacity at least, so appending is amortized constant time.
+		void grow(std::size_t required)
 		{
-			binary,
-			decimal,
-			octal,
-			hex,
-			normal_float,
-			scientific_float,
-			normal,
-			string,
-			character,
-			fail
-		};
+			std::size_t const new_capacity = std::max(required, storage_capacity + storage_capacity / 2);
+			std::unique_ptr<CharT[]> new_storage(new CharT[new_capacity]);
+			std::copy_n(storage, length, new_storage.get());
 
+			heap_storage = std::move(new_storage);
+			storage = heap_storage.get();
+			storage_capacity = new_capacity;
+		}
 
-		// Where to put zeroes and spaces when filling up a field to width.
-		enum class fill_alignment
+	public:
+		using value_type = CharT;
+		using size_type = std::size_t;
+		using iterator = CharT*;
+		using const_iterator = CharT const*;
+
+		basic_memory_buffer() noexcept = default;
+
+		basic_memory_buffer(basic_memory_buffer&& other) noexcept
 		{
-			left,
-			intern,
-			right
-		};
+			*this = std::move(other);
+		}
 
+		basic_memory_buffer& operator=(basic_memory_buffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (other.heap_storage)
+				{
+					heap_storage = std::move(other.heap_storage);
+					storage = heap_storage.get();
+					storage_capacity = other.storage_capacity;
+				}
+				else
+				{
+					heap_storage.reset();
+					storage = inline_storage.data();
+					storage_capacity = InlineN;
+					std::copy_n(other.storage, other.length, storage);
+				}
 
-		// How to display the sign of positive numbers
-		enum class pos_sign_type
+				length = other.length;
+				other.storage = other.inline_storage.data();
+				other.storage_capacity = InlineN;
+				other.length = 0;
+			}
+			return *this;
+		}
+
+		basic_memory_buffer(basic_memory_buffer const&) = delete;
+		basic_memory_buffer& operator=(basic_memory_buffer const&) = delete;
+
+
+		CharT* data() noexcept
 		{
-			plus,
-			space,
-			none
-		};
+			return storage;
+		}
 
+		CharT const* data() const noexcept
+		{
+			return storage;
+		}
 
-		struct conversion_options
+		std::size_t size() const noexcept
 		{
-			conversion_format format = conversion_format::normal;
-			int width = 0;
-			int precision = 6;
-			fill_alignment alignment = fill_alignment::left;
-			pos_sign_type pos_sign = pos_sign_type::none;
-			bool zero_fill = false;
+			return length;
+		}
 
-			conversion_options(
-					conversion_format format = conversion_format::normal, int width = 0,
-					int precision = 6,
-					fill_alignment align = fill_alignment::left,
-					pos_sign_type pos_sign = pos_sign_type::none,
-					bool zero_fill = false)
-					: format(format), width(width), precision(precision), alignment(align),
-					  pos_sign(pos_sign),
-					  zero_fill(zero_fill)
-			{
-			}
-		};
+		// Number of characters that fit without allocating memory
+		std::size_t capacity() const noexcept
+		{
+			return storage_capacity;
+		}
 
-		template<typename InputIt>
-		inline void ensure_not_equal(InputIt const& a, InputIt const& b)
+		bool empty() const noexcept
 		{
-			if (a == b)
-			{
-				throw std::invalid_argument("unterminated {");
-			}
+			return length == 0;
 		}
 
-		// Helper class to parse the conversion options
-		template<typename InputIt>
-		class option_reader
+		CharT* begin() noexcept
 		{
-			typedef typename std::iterator_traits<InputIt>::value_type char_type;
+			return storage;
+		}
 
-			// Observe the initialization of member variables.
-			// Reference: https://stackoverflow.com/a/27669457
+		CharT* end() noexcept
+		{
+			return storage + length;
+		}
 
-			const std::array<std::pair<char_type, fill_alignment>, 3> alignment_types{{
-					{ '>', fill_alignment::left },
-					{ '_', fill_alignment::intern },
-					{ '<', fill_alignment::right }
-			}};
+		CharT const* begin() const noexcept
+		{
+			return storage;
+		}
 
-			const std::array<std::pair<char_type, pos_sign_type>, 3> sign_types{{
-					{ '+', pos_sign_type::plus },
-					{ ' ', pos_sign_type::space },
-					{ '-', pos_sign_type::none }
-			}};
+		CharT const* end() const noexcept
+		{
+			return storage + length;
+		}
 
-			const std::array<std::pair<char_type, conversion_format>, 8> format_types{{
-					{ 'b', conversion_format::binary },
-					{ 'd', conversion_format::decimal },
-					{ 'o', conversion_format::octal },
-					{ 'x', conversion_format::hex },
-					{ 'e', conversion_format::scientific_float },
-					{ 'f', conversion_format::normal_float },
-					{ 's', conversion_format::string },
-					{ 'c', conversion_format::character }
-			}};
+		std::basic_string_view<CharT> view() const noexcept
+		{
+			return { storage, length };
+		}
 
-			InputIt& it;
-			InputIt const end;
+		std::basic_string<CharT> str() const
+		{
+			return { storage, length };
+		}
 
-		public:
-			conversion_options options;
 
-			inline option_reader(InputIt& start, InputIt const end)
-					: it(start), end(end)
+		// Remove all characters, keeping the memory for reuse.
+		void clear() noexcept
+		{
+			length = 0;
+		}
+
+		void reserve(std::size_t new_capacity)
+		{
+			if (new_capacity > storage_capacity)
 			{
-				read_options();
+				grow(new_capacity);
 			}
+		}
 
+		// Change the number of characters. New characters are left
+		// uninitialized, to be written to through data().
+		void resize(std::size_t new_size)
+		{
+			reserve(new_size);
+			length = new_size;
+		}
 
-			// Ensure the input iterator is not at the end of input.
-			inline void check_it() const
+		void push_back(CharT c)
+		{
+			if (length == storage_capacity)
 			{
-				ensure_not_equal(it, end);
+				grow(length + 1);
 			}
+			storage[length++] = c;
+		}
 
+		template<typename InputIt>
+		void append(InputIt first, InputIt last)
+		{
+			auto const count = std::size_t(std::distance(first, last));
+			reserve(length + count);
+			std::copy(first, last, storage + length);
+			length += count;
+		}
 
-			// Read a character from the input iterator, map it to one of the given values.
-			template<typename ValueT, std::size_t Number>
-			inline void
-			map_char(std::array<std::pair<char_type, ValueT>, Number> const& values, ValueT& out)
-			{
-				check_it();
-				auto const c = *it;
-				auto v = std::find_if(values.begin(), values.end(), [=](auto const& a)
-				{ return a.first == c; });
-				if (v != values.end())
-				{
-					out = v->second;
-					++it;
-				}
-			}
+		void append(std::size_t count, CharT c)
+		{
+			reserve(length + count);
+			std::fill_n(storage + length, count, c);
+			length += count;
+		}
+	};
 
 
-			// Read alignment of field
-			inline void read_align()
-			{
-				map_char(alignment_types, options.alignment);
-			}
+	using memory_buffer = basic_memory_buffer<char>;
+	using wmemory_buffer = basic_memory_buffer<wchar_t>;
 
 
-			// Read zero-fill field
-			inline void read_fill()
+#ifdef FLOSSY_ENABLE_STATS
+	/**
+	 * @page Statistics.
+	 *
+	 * If FLOSSY_ENABLE_STATS is defined, format, format_to and format_to_n
+	 * record the cost of every call with values, per format string. Each
+	 * thread counts in its own table, stats_snapshot sums the tables of all
+	 * threads (including threads that have ended). Without
+	 * FLOSSY_ENABLE_STATS, nothing is recorded and these functions do not
+	 * exist.
+	 *
+	 * Heap allocations are counted by calling stats_count_allocation from a
+	 * replacement of the global operator new:
+	 *
+	 * @code
+	 * void* operator new(std::size_t size)
+	 * {
+	 * 	flossy::stats_count_allocation();
+	 * 	...
+	 * }
+	 * @endcode
+	 */
+	struct format_stats
+	{
+		// The format string, characters outside of ASCII replaced by '?'
+		std::string format_str;
+		// Number of placeholders in the format string
+		std::size_t placeholders = 0;
+		// Number of calls
+		std::uint64_t calls = 0;
+		// Bytes produced (characters times their size)
+		std::uint64_t bytes = 0;
+		// Heap allocations counted by stats_count_allocation during the calls
+		std::uint64_t allocations = 0;
+		// Time spent in the calls
+		std::uint64_t nanoseconds = 0;
+		// Time stamp counter cycles spent in the calls (x86 only, 0 elsewhere)
+		std::uint64_t cycles = 0;
+	};
+
+
+	namespace internal
+	{
+		// Statistics by format string. The keys refer to copies of the format
+		// strings (their bytes) owned by the map.
+		class stats_map
+		{
+			std::deque<std::string> keys;
+			std::unordered_map<std::string_view, format_stats> sites;
+
+		public:
+			template<typename InitFunc>
+			format_stats& get(std::string_view key, InitFunc const& init)
 			{
-				check_it();
-				if (*it == '0')
+				auto const site = sites.find(key);
+				if (site != sites.end())
 				{
-					++it;
-					options.zero_fill = true;
+					return site->second;
 				}
-			}
-
 
-			// Read positive sign flag (none, space or plus)
-			inline void read_sign()
-			{
-				map_char(sign_types, options.pos_sign);
+				keys.emplace_back(key);
+				return sites.emplace(keys.back(), init()).first->second;
 			}
 
-
-			inline int read_number()
+			void add(stats_map const& other)
 			{
-				int v = 0;
-				for (;;)
+				for (auto const& [key, stats] : other.sites)
 				{
-					check_it();
-					auto const c = *it;
-					if (c >= '0' && c <= '9')
-					{
-						v = v * 10 + (c - '0');
-						++it;
-					}
-					else
+					auto& sum = get(key, [&]
 					{
-						return v;
-					}
+						return format_stats{ stats.format_str, stats.placeholders };
+					});
+					sum.calls += stats.calls;
+					sum.bytes += stats.bytes;
+					sum.allocations += stats.allocations;
+					sum.nanoseconds += stats.nanoseconds;
+					sum.cycles += stats.cycles;
 				}
 			}
 
-
-			inline void read_width()
+			void clear()
 			{
-				options.width = read_number();
+				sites.clear();
+				keys.clear();
 			}
 
-
-			inline void read_precision()
+			std::vector<format_stats> values() const
 			{
-				check_it();
-				if (*it == '.')
+				std::vector<format_stats> result;
+				for (auto const& site : sites)
 				{
-					++it;
-					options.precision = read_number();
+					result.push_back(site.second);
 				}
+				return result;
 			}
+		};
 
 
-			inline void read_format()
-			{
-				map_char(format_types, options.format);
-			}
-
+		// The statistics of one thread. The mutex is only contended while a
+		// snapshot is taken.
+		struct stats_table
+		{
+			std::mutex mutex;
+			stats_map sites;
+		};
 
-			inline void read_options()
-			{
-				read_align();
-				read_sign();
-				read_fill();
-				read_width();
-				read_precision();
-				read_format();
 
-				check_it();
-				if (*it != '}')
-				{
-					throw std::invalid_argument("Invalid character in format string");
-				}
-				++it;
-			}
+		// The tables of all running threads, and the sums of the ended ones
+		struct stats_registry
+		{
+			std::mutex mutex;
+			std::vector<stats_table*> tables;
+			stats_map ended;
 		};
 
 
-		// Output string with space padding on the appropriate side
-		template<typename CharT, typename OutIt, typename InputIt>
-		OutIt
-		format_string(OutIt out, conversion_options const& options, InputIt start, InputIt end)
+		inline stats_registry& get_stats_registry()
 		{
-			int fill_count = options.width - (end - start);
-			if (fill_count < 0)
-			{
-				fill_count = 0;
-			}
+			static stats_registry registry;
+			return registry;
+		}
 
-			if (options.alignment == fill_alignment::left)
+
+		// Registers the table of a thread for its lifetime
+		class thread_stats
+		{
+		public:
+			stats_table table;
+
+			thread_stats()
 			{
-				out = std::fill_n(out, fill_count, CharT(' '));
-				out = std::copy(start, end, out);
+				auto& registry = get_stats_registry();
+				std::lock_guard<std::mutex> const lock(registry.mutex);
+				registry.tables.push_back(&table);
 			}
-			else
+
+			~thread_stats()
 			{
-				out = std::copy(start, end, out);
-				out = std::fill_n(out, fill_count, CharT(' '));
+				auto& registry = get_stats_registry();
+				std::lock_guard<std::mutex> const lock(registry.mutex);
+				registry.ended.add(table.sites);
+				registry.tables.erase(std::find(registry.tables.begin(), registry.tables.end(), &table));
 			}
+		};
 
-			return out;
+
+		inline stats_table& get_thread_stats()
+		{
+			static thread_local thread_stats stats;
+			return stats.table;
 		}
 
 
-		// Digits for integer conversions
-		template<typename CharT>
-		constexpr CharT digit_chars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a',
-											'b', 'c', 'd', 'e',
-											'f' };
+		inline thread_local std::uint64_t thread_allocations = 0;
 
 
-		// Convert format flag to number system base
-		template<typename ValueT>
-		constexpr ValueT int_format_radix(conversion_format format)
+		inline std::uint64_t read_cycles() noexcept
 		{
-			switch (format)
+#ifdef FLOSSY_HAS_RDTSC
+			return __rdtsc();
+#else
+			return 0;
+#endif
+		}
+
+
+		// Number of placeholders, not counting escaped braces
+		template<typename CharT>
+		std::size_t count_placeholders(std::basic_string_view<CharT> format_str)
+		{
+			std::size_t count = 0;
+			for (std::size_t i = 0; i < format_str.size(); ++i)
 			{
-			case conversion_format::hex:
-				return ValueT(16);
-			case conversion_format::octal:
-				return ValueT(8);
-			case conversion_format::binary:
-				return ValueT(2);
-			default:
-				return ValueT(10);
+				if (format_str[i] == '{')
+				{
+					if (i + 1 < format_str.size() && format_str[i + 1] == '{')
+					{
+						++i;
+						continue;
+					}
+					++count;
+					while (i < format_str.size() && format_str[i] != '}')
+					{
+						++i;
+					}
+				}
 			}
+			return count;
 		}
 
 
-		// Holds the characters of a string with the appropriate size for all numbers
+		// Measures one format call. finish is passed a function returning the
+		// number of characters produced, and records the call.
 		template<typename CharT>
-		struct digit_buffer
+		class stats_scope
 		{
-			// This should be enough space for all integer types supported by the
-			// compiler, in binary representation and thus for all integer types in all
-			// bases.
-			std::array<CharT, std::numeric_limits<uintmax_t>::digits> digits;
-			int count = 0;
+			using clock = std::chrono::steady_clock;
 
+			std::basic_string_view<CharT> format_str;
+			std::uint64_t const start_allocations = thread_allocations;
+			clock::time_point const start_time = clock::now();
+			std::uint64_t const start_cycles = read_cycles();
 
-			// Insert character into buffer.
-			void insert(CharT c)
+		public:
+			explicit stats_scope(std::basic_string_view<CharT> format_str)
+					: format_str(format_str)
 			{
-				digits[count++] = c;
 			}
 
-
-			// Copy the accumulated characters to the output iterator
-			template<typename OutIt>
-			OutIt output(OutIt out) const
+			template<typename SizeFunc>
+			void finish(SizeFunc const& size) const
 			{
-				for (int i = count; i > 0; --i)
+				std::uint64_t const cycles = read_cycles() - start_cycles;
+				auto const time = clock::now() - start_time;
+				std::uint64_t const allocations = thread_allocations - start_allocations;
+
+				auto& table = get_thread_stats();
+				std::lock_guard<std::mutex> const lock(table.mutex);
+
+				std::string_view const key(reinterpret_cast<char const*>(format_str.data()),
+						format_str.size() * sizeof(CharT));
+				auto& stats = table.sites.get(key, [&]
 				{
-					*out++ = digits[i - 1];
-				}
-				return out;
+					format_stats result;
+					for (CharT c : format_str)
+					{
+						result.format_str += std::uint32_t(c) < 128 ? char(c) : '?';
+					}
+					result.placeholders = count_placeholders(format_str);
+					return result;
+				});
+
+				++stats.calls;
+				stats.bytes += size() * sizeof(CharT);
+				stats.allocations += allocations;
+				stats.nanoseconds += std::uint64_t(
+						std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+				stats.cycles += cycles;
 			}
 		};
+	}
 
 
-		// Generate the digit characters for the given unsigned value
-		template<typename CharT, typename ValueT>
-		digit_buffer<CharT> generate_digits(ValueT value, conversion_format const& format)
-		{
-			static_assert(std::is_unsigned<ValueT>::value,
-					"ValueT must be unsigned in generate_digits");
-
-			digit_buffer<CharT> digits;
+	// Count a heap allocation for the statistics of the running format call.
+	inline void stats_count_allocation() noexcept
+	{
+		++internal::thread_allocations;
+	}
 
-			const ValueT radix = int_format_radix<ValueT>(format);
 
-			do
-			{
-				digits.insert(digit_chars<CharT>[value % radix]);
-				value /= radix;
-			} while (value);
+	// The statistics of all threads, the most expensive format strings first.
+	inline std::vector<format_stats> stats_snapshot()
+	{
+		internal::stats_map sum;
+		auto& registry = internal::get_stats_registry();
+		std::lock_guard<std::mutex> const lock(registry.mutex);
 
-			return digits;
+		sum.add(registry.ended);
+		for (auto* table : registry.tables)
+		{
+			std::lock_guard<std::mutex> const table_lock(table->mutex);
+			sum.add(table->sites);
 		}
 
-
-		// The sign character to output when formatting a number
-		enum class sign_character
+		auto result = sum.values();
+		std::sort(result.begin(), result.end(), [](format_stats const& a, format_stats const& b)
 		{
-			none,
-			space,
-			plus,
-			minus
-		};
+			return a.nanoseconds > b.nanoseconds;
+		});
+		return result;
+	}
 
 
-		// Output the given sign to the iterator
-		template<typename CharT, typename OutIt>
-		OutIt output_sign(OutIt out, sign_character sign)
-		{
-			if (sign == sign_character::space)
-			{
-				*out++ = CharT(' ');
-			}
-			else if (sign == sign_character::plus)
-			{
-				*out++ = CharT('+');
-			}
-			else if (sign == sign_character::minus)
-			{
-				*out++ = CharT('-');
-			}
+	// Forget the statistics of all threads.
+	inline void stats_reset()
+	{
+		auto& registry = internal::get_stats_registry();
+		std::lock_guard<std::mutex> const lock(registry.mutex);
 
-			return out;
+		registry.ended.clear();
+		for (auto* table : registry.tables)
+		{
+			std::lock_guard<std::mutex> const table_lock(table->mutex);
+			table->sites.clear();
 		}
+	}
 
 
-		// Output values given by out_func to the output iterator and add padding and
-		// sign characters.
-		template<typename CharT, typename OutIt, typename DigitOutFunc>
-		OutIt output_padded_with_sign(
-				OutIt out, DigitOutFunc out_func, int digit_count,
-				conversion_options const& options,
-				sign_character sign)
-		{
-			int fill_count = options.width - digit_count - (sign == sign_character::none ? 0 : 1);
+	// Write stats_snapshot as a table, one format string per line.
+	inline void stats_dump(std::ostream& out)
+	{
+		out << std::setw(10) << "calls" << std::setw(12) << "bytes" << std::setw(6) << "{}"
+			<< std::setw(10) << "allocs" << std::setw(14) << "ns" << std::setw(10) << "ns/call"
+			<< std::setw(12) << "cycles/call" << "  format string\n";
 
-			if (fill_count < 0)
+		for (auto const& stats : stats_snapshot())
+		{
+			std::string text;
+			for (char c : stats.format_str)
 			{
-				fill_count = 0;
+				text += c == '\n' ? std::string("\\n") : std::string(1, c);
 			}
 
-			const auto fill = options.zero_fill ? CharT('0') : CharT(' ');
+			auto const calls = std::max<std::uint64_t>(stats.calls, 1);
+			out << std::setw(10) << stats.calls << std::setw(12) << stats.bytes
+				<< std::setw(6) << stats.placeholders << std::setw(10) << stats.allocations
+				<< std::setw(14) << stats.nanoseconds << std::setw(10) << stats.nanoseconds / calls
+				<< std::setw(12) << stats.cycles / calls << "  " << text << '\n';
+		}
+	}
 
-			if (options.alignment == fill_alignment::left)
-			{
-				out = std::fill_n(out, fill_count, fill);
-				out = output_sign<CharT>(out, sign);
-				out = out_func();
-			}
-			else if (options.alignment == fill_alignment::intern)
+#else
+	namespace internal
+	{
+		// Without FLOSSY_ENABLE_STATS, measuring a format call does nothing.
+		template<typename CharT>
+		struct stats_scope
+		{
+			explicit stats_scope(std::basic_string_view<CharT>) noexcept
 			{
-				out = output_sign<CharT>(out, sign);
-				out = std::fill_n(out, fill_count, fill);
-				out = out_func();
 			}
-			else if (options.alignment == fill_alignment::right)
+
+			template<typename SizeFunc>
+			void finish(SizeFunc const&) const noexcept
 			{
-				out = output_sign<CharT>(out, sign);
-				out = out_func();
-				out = std::fill_n(out, fill_count, fill);
 			}
+		};
+	}
+#endif
 
-			return out;
-		}
 
+	// Kinds of errors in format strings
+	enum class format_errc
+	{
+		none,
+		// A conversion specifier is not closed by '}' before the end of the string
+		unterminated_placeholder,
+		// A conversion specifier contains a character that is not an option
+		invalid_character,
+		// A parsed_format for a number of values has a different number of placeholders
+		placeholder_count
+	};
 
-		// Format a decomposed integer with fill characters and sign
-		template<typename OutIt, typename CharT>
-		OutIt output_integer(
-				OutIt out, digit_buffer<CharT> const& digits, conversion_options const& options,
-				sign_character sign)
-		{
-			auto out_func = [&]()
-			{
-				return digits.output(out);
-			};
 
-			return output_padded_with_sign<CharT>(out, out_func, digits.count,
-					options, sign);
-		}
+	/**
+	 * @page Format String Errors.
+	 *
+	 * Result of checking a format string. Converts to true if the format
+	 * string is valid.
+	 *
+	 * @example
+	 * @code
+	 * auto const status = flossy::check_format(message_template);
+	 * if (!status)
+	 * {
+	 *   std::cerr << status.message() << " at " << status.offset << '\n';
+	 * }
+	 * @endcode
+	 */
+	struct format_status
+	{
+		format_errc error = format_errc::none;
+		// Position in the format string: the '{' of an unterminated conversion
+		// specifier or the invalid character.
+		std::size_t offset = 0;
 
+		constexpr explicit operator bool() const noexcept
+		{
+			return error == format_errc::none;
+		}
 
-		// Get the sign character required to display the given sign with the given
-		// representation of positive numbers
-		constexpr sign_character sign_from_format(const bool neg, const pos_sign_type pos)
+		// Description of the error, also the message of the std::invalid_argument
+		// thrown for it.
+		constexpr char const* message() const noexcept
 		{
-			if (neg)
+			switch (error)
 			{
-				return sign_character::minus;
+			case format_errc::none:
+				return "No error";
+			case format_errc::unterminated_placeholder:
+				return "unterminated {";
+			case format_errc::invalid_character:
+				return "Invalid character in format string";
+			case format_errc::placeholder_count:
+				return "Number of placeholders does not match the number of values";
 			}
+			return "Unknown error";
+		}
+	};
 
-			switch (pos)
-			{
-			case pos_sign_type::plus:
-				return sign_character::plus;
-			case pos_sign_type::space:
-				return sign_character::space;
-			default:
-				return sign_character::none;
-			}
+
+	namespace internal
+	{
+		// The only place errors are raised. Throws std::invalid_argument, or
+		// aborts with FLOSSY_NO_EXCEPTIONS. Not inlined, so the callers on the
+		// formatting path stay small.
+		[[noreturn]]
+#if defined(__GNUC__)
+		__attribute__((noinline, cold))
+#elif defined(_MSC_VER)
+		__declspec(noinline)
+#endif
+		inline void raise_error(char const* message)
+		{
+#ifdef FLOSSY_NO_EXCEPTIONS
+			(void) message;
+			std::abort();
+#else
+			throw std::invalid_argument(message);
+#endif
 		}
 
 
-		// Format an unsigned integer without validity checks for given flags with
-		// given sign and options.
-		template<typename CharT, typename OutIt, typename ValueT>
-		typename std::enable_if<
-				std::is_integral<ValueT>::value && std::is_unsigned<ValueT>::value, OutIt>::type
-		format_integer_unchecked(OutIt out, ValueT value, bool negative,
-				conversion_options const& options)
+		[[noreturn]] inline void raise_error(format_errc error)
 		{
-			// Special case: Conversion to character requested
-			if (options.format == conversion_format::character)
-			{
-				*out++ = CharT(value);
-			}
-			else
-			{
-				digit_buffer<CharT> digits = generate_digits<CharT>(value, options.format);
+			raise_error(format_status{ error, 0 }.message());
+		}
+	}
 
-				out = output_integer(out, digits, options,
-						sign_from_format(negative, options.pos_sign));
 
-			}
+	namespace internal
+	{
 
-			return out;
-		}
+		// Used only for types that allow different representations, i.e. not for
+		// strings.
+		enum class conversion_format : std::uint8_t
+		{
+			binary,
+			decimal,
+			octal,
+			hex,
+			normal_float,
+			scientific_float,
+			shortest_float,
+			normal,
+			string,
+			character,
+			fail
+		};
 
 
-		// Format unsigned integer with checks for flag validity with given sign and options.
-		template<typename CharT, typename OutIt, typename ValueT>
-		typename std::enable_if<
-				std::is_integral<ValueT>::value && std::is_unsigned<ValueT>::value, OutIt>::type
-		format_integer(OutIt out, ValueT value, bool negative, conversion_options options)
+		// Where to put zeroes and spaces when filling up a field to width.
+		enum class fill_alignment : std::uint8_t
 		{
-			if (options.alignment != fill_alignment::intern)
-			{
-				options.zero_fill = false;
-			}
+			left,
+			intern,
+			right
+		};
 
-			return format_integer_unchecked<CharT>(out, value, negative, options);
-		}
+
+		// How to display the sign of positive numbers
+		enum class pos_sign_type : std::uint8_t
+		{
+			plus,
+			space,
+			none
+		};
 
 
-		// Absolute value of given value as the unsigned type with same width as
-		// input type (this allows // getting the absolute value of the lowest integer
-		// without overflow).
-		template<typename ValueT>
-		typename std::make_unsigned<ValueT>::type make_positive(ValueT value)
+		// The options of a placeholder. They are passed by value to every
+		// formatter, so they are kept to 64 bits, which are passed in a single
+		// register.
+		struct conversion_options
 		{
-			if (value >= 0)
+			// Largest width and precision, larger numbers in the format string
+			// are clamped to it.
+			static constexpr int max_number = std::numeric_limits<std::int16_t>::max();
+
+			// Precision used if the format string gives none
+			static constexpr int default_precision = 6;
+
+			std::int16_t width = 0;
+			std::int16_t precision = default_precision;
+			conversion_format format = conversion_format::normal;
+			fill_alignment alignment = fill_alignment::left;
+			pos_sign_type pos_sign = pos_sign_type::none;
+			bool zero_fill = false;
+
+			constexpr conversion_options(
+					conversion_format format = conversion_format::normal, int width = 0,
+					int precision = default_precision,
+					fill_alignment align = fill_alignment::left,
+					pos_sign_type pos_sign = pos_sign_type::none,
+					bool zero_fill = false)
+					: width(std::int16_t(width)), precision(std::int16_t(precision)), format(format),
+					  alignment(align), pos_sign(pos_sign), zero_fill(zero_fill)
 			{
-				return static_cast<typename std::make_unsigned<ValueT>::type>(value);
 			}
-			else
+
+
+			// True for the options of a plain "{}": no padding, no sign for
+			// positive numbers, the default precision and the normal
+			// representation. Formatters use this to skip the padding and sign
+			// logic.
+			constexpr bool is_default() const noexcept
 			{
-				return ~(static_cast<typename std::make_unsigned<ValueT>::type>(value) - 1U);
+				return width == 0 && precision == default_precision
+					   && format == conversion_format::normal
+					   && pos_sign == pos_sign_type::none;
 			}
-		}
+		};
 
-		// String formatter for C-Strings
-		template<typename CharT, typename OutIt>
-		OutIt format_element(OutIt out, conversion_options const& options, CharT const* value)
+		static_assert(sizeof(conversion_options) == sizeof(std::uint64_t),
+				"conversion_options must fit into a register");
+
+
+		template<typename InputIt>
+		constexpr void ensure_not_equal(InputIt const& a, InputIt const& b)
 		{
-			CharT const* end = value;
-			while (*end != CharT('\0'))
+			if (a == b)
 			{
-				++end;
+				raise_error(format_errc::unterminated_placeholder);
 			}
-
-			return format_string<CharT>(out, options, value, end);
 		}
 
-
-		// String formatter for C++ strings
-		template<typename CharT, typename OutIt>
-		OutIt format_element(OutIt out, conversion_options const& options,
-				std::basic_string_view<CharT> value)
+		// Helper class to parse the conversion options
+		template<typename InputIt>
+		class option_reader
 		{
-			return format_string<CharT>(out, options, value.begin(), value.end());
-		}
+			typedef typename std::iterator_traits<InputIt>::value_type char_type;
 
+			// The lookup tables are shared by all readers, so creating a reader for
+			// every conversion specifier does not copy them around.
 
-		// If there are not value left to convert, just copy the rest of the input.
-		// Ignore further conversion specifiers.
-		template<typename OutIt, typename InputIt>
-		OutIt format_it(OutIt out, InputIt start, InputIt const end)
-		{
-			return std::copy(start, end, out);
-		}
+			static constexpr std::array<std::pair<char_type, fill_alignment>, 3> alignment_types{{
+					{ '>', fill_alignment::left },
+					{ '_', fill_alignment::intern },
+					{ '<', fill_alignment::right }
+			}};
 
+			static constexpr std::array<std::pair<char_type, pos_sign_type>, 3> sign_types{{
+					{ '+', pos_sign_type::plus },
+					{ ' ', pos_sign_type::space },
+					{ '-', pos_sign_type::none }
+			}};
 
-		// Formatter function for unsigned integers
-		template<typename CharT, typename OutIt, typename ValueT>
-		typename std::enable_if<
-				std::is_integral<ValueT>::value && std::is_unsigned<ValueT>::value, OutIt>::type
-		format_element(OutIt out, conversion_options options, ValueT value)
+			static constexpr std::array<std::pair<char_type, conversion_format>, 9> format_types{{
+					{ 'b', conversion_format::binary },
+					{ 'd', conversion_format::decimal },
+					{ 'o', conversion_format::octal },
+					{ 'x', conversion_format::hex },
+					{ 'e', conversion_format::scientific_float },
+					{ 'f', conversion_format::normal_float },
+					{ 'r', conversion_format::shortest_float },
+					{ 's', conversion_format::string },
+					{ 'c', conversion_format::character }
+			}};
+
+			InputIt& it;
+			InputIt const end;
+			format_errc error = format_errc::none;
+
+		public:
+			conversion_options options;
+
+			// Read the options, raise an error for invalid ones.
+			constexpr option_reader(InputIt& start, InputIt const end)
+					: it(start), end(end)
+			{
+				read_options();
+
+				if (error != format_errc::none)
+				{
+					raise_error(error);
+				}
+			}
+
+			// Read the options, leave invalid ones to be reported by status. The
+			// input iterator is left at the invalid character.
+			constexpr option_reader(InputIt& start, InputIt const end, std::nothrow_t) noexcept
+					: it(start), end(end)
+			{
+				read_options();
+			}
+
+
+			constexpr format_errc status() const noexcept
+			{
+				return error;
+			}
+
+
+			// Read a character from the input iterator, map it to one of the given values.
+			// Returns current if the character is none of the given ones.
+			template<typename ValueT, std::size_t Number>
+			constexpr ValueT
+			map_char(std::array<std::pair<char_type, ValueT>, Number> const& values, ValueT current) noexcept
+			{
+				if (it == end)
+				{
+					return current;
+				}
+
+				auto const c = *it;
+				for (auto const& value : values)
+				{
+					if (value.first == c)
+					{
+						++it;
+						return value.second;
+					}
+				}
+
+				return current;
+			}
+
+
+			// Read alignment of field
+			constexpr void read_align() noexcept
+			{
+				options.alignment = map_char(alignment_types, options.alignment);
+			}
+
+
+			// Read zero-fill field
+			constexpr void read_fill() noexcept
+			{
+				if (it != end && *it == '0')
+				{
+					++it;
+					options.zero_fill = true;
+				}
+			}
+
+
+			// Read positive sign flag (none, space or plus)
+			constexpr void read_sign() noexcept
+			{
+				options.pos_sign = map_char(sign_types, options.pos_sign);
+			}
+
+
+			constexpr int read_number() noexcept
+			{
+				int v = 0;
+				while (it != end)
+				{
+					auto const c = *it;
+					if (c < '0' || c > '9')
+					{
+						break;
+					}
+					v = v * 10 + (c - '0');
+					if (v > conversion_options::max_number)
+					{
+						v = conversion_options::max_number;
+					}
+					++it;
+				}
+				return v;
+			}
+
+
+			constexpr void read_width() noexcept
+			{
+				options.width = std::int16_t(read_number());
+			}
+
+
+			constexpr void read_precision() noexcept
+			{
+				if (it != end && *it == '.')
+				{
+					++it;
+					options.precision = std::int16_t(read_number());
+				}
+			}
+
+
+			constexpr void read_format() noexcept
+			{
+				options.format = map_char(format_types, options.format);
+			}
+
+
+			// The readers above stop at the end of the input, which is only
+			// reported here, so a valid specifier is checked just once.
+			constexpr void read_options() noexcept
+			{
+				read_align();
+				read_sign();
+				read_fill();
+				read_width();
+				read_precision();
+				read_format();
+
+				if (it == end)
+				{
+					error = format_errc::unterminated_placeholder;
+				}
+				else if (*it != '}')
+				{
+					error = format_errc::invalid_character;
+				}
+				else
+				{
+					++it;
+				}
+			}
+		};
+
+
+		// Output iterator that only counts the characters written to it. Used to
+		// compute the size of formatted output without producing it. The integer
+		// and string formatters recognize it and skip generating the characters.
+		class counting_iterator
 		{
-			return format_integer<CharT>(out, value, false, options);
-		}
+			std::size_t written = 0;
 
+		public:
+			using iterator_category = std::output_iterator_tag;
+			using value_type = void;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = void;
+
+			// Number of characters written so far
+			std::size_t count() const noexcept
+			{
+				return written;
+			}
 
-		// Formatter function for a signed integer. Converts the given number bitwise to
-		// an unsigned value if the requested conversion is _not_ decimal. For decimal,
-		// it passes the absolute value and sign bit appropriately
-		template<typename CharT, typename OutIt, typename ValueT>
-		typename std::enable_if<
-				std::is_integral<ValueT>::value && std::is_signed<ValueT>::value, OutIt>::type
-		format_element(OutIt out, conversion_options options, ValueT value)
+			counting_iterator& operator*() noexcept
+			{
+				return *this;
+			}
+
+			template<typename CharT>
+			counting_iterator& operator=(CharT const&) noexcept
+			{
+				return *this;
+			}
+
+			counting_iterator& operator++() noexcept
+			{
+				++written;
+				return *this;
+			}
+
+			counting_iterator operator++(int) noexcept
+			{
+				counting_iterator const previous = *this;
+				++written;
+				return previous;
+			}
+
+			// Skip count characters at once
+			counting_iterator operator+(std::size_t count) const noexcept
+			{
+				counting_iterator result = *this;
+				result.written += count;
+				return result;
+			}
+		};
+
+
+		template<typename OutIt>
+		constexpr bool is_counting_iterator = std::is_same<OutIt, counting_iterator>::value;
+
+
+		// Output iterator writing to a buffer of fixed size. Characters that do not
+		// fit are dropped, but still counted, so the size the complete output
+		// would need is known afterwards.
+		template<typename CharT>
+		class truncating_iterator
 		{
-			if (options.format != conversion_format::normal and
-				options.format != conversion_format::decimal)
+			CharT* position;
+			std::size_t remaining;
+			std::size_t written = 0;
+
+		public:
+			using iterator_category = std::output_iterator_tag;
+			using value_type = void;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = void;
+
+			truncating_iterator(CharT* buffer, std::size_t size) noexcept
+					: position(buffer), remaining(size)
 			{
-				return format_integer<CharT>(out,
-						static_cast<typename std::make_unsigned<ValueT>::type>(value), false,
-						options);
 			}
-			else
+
+			// Number of characters written so far, including the dropped ones
+			std::size_t count() const noexcept
 			{
-				return format_integer<CharT>(out, make_positive(value), value < 0, options);
+				return written;
 			}
-		}
 
+			// True if no more characters fit into the buffer
+			bool full() const noexcept
+			{
+				return remaining == 0;
+			}
 
-// Formatter function for floating point numbers.
+			truncating_iterator& operator*() noexcept
+			{
+				return *this;
+			}
 
-#if FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_SSTREAM
-		// This method used C++ string streams to convert float values. That means it
-		// is precise and easy to implement. String streams use dynamic memory though,
-		// so it may have unpredictable timing and be slower than other alternatives.
+			truncating_iterator& operator=(CharT c) noexcept
+			{
+				if (remaining)
+				{
+					*position = c;
+				}
+				return *this;
+			}
 
-		template<typename CharT, typename OutIt, typename ValueT>
-		typename std::enable_if<std::is_floating_point<ValueT>::value, OutIt>::type
-		format_element(OutIt out, conversion_options options, ValueT value)
+			truncating_iterator& operator++() noexcept
+			{
+				if (remaining)
+				{
+					++position;
+					--remaining;
+				}
+				++written;
+				return *this;
+			}
+
+			truncating_iterator operator++(int) noexcept
+			{
+				truncating_iterator const previous = *this;
+				++*this;
+				return previous;
+			}
+
+			// Count characters that are not written, because the buffer is full.
+			truncating_iterator operator+(std::size_t count) const noexcept
+			{
+				truncating_iterator result = *this;
+				result.written += count;
+				return result;
+			}
+
+			// Write the characters from first to last, as far as they fit.
+			template<typename InputIt>
+			truncating_iterator write(InputIt first, InputIt last) const
+			{
+				auto const length = std::size_t(std::distance(first, last));
+				auto const copied = std::min(length, remaining);
+
+				truncating_iterator result(std::copy_n(first, copied, position), remaining - copied);
+				result.written = written + length;
+				return result;
+			}
+
+			// Write count fill characters, as far as they fit.
+			truncating_iterator fill(std::size_t count, CharT c) const
+			{
+				auto const copied = std::min(count, remaining);
+
+				truncating_iterator result(std::fill_n(position, copied, c), remaining - copied);
+				result.written = written + count;
+				return result;
+			}
+		};
+
+
+		template<typename OutIt>
+		constexpr bool is_truncating_iterator = false;
+
+		template<typename CharT>
+		constexpr bool is_truncating_iterator<truncating_iterator<CharT>> = true;
+
+
+		// Collects the output for a stream in a buffer on the stack and passes it
+		// on to the stream buffer in chunks, instead of one stream insertion per
+		// character.
+		template<typename CharT, typename Traits>
+		class stream_writer
 		{
-			if (options.alignment != fill_alignment::intern || std::isinf(value))
+			std::basic_streambuf<CharT, Traits>& streambuf;
+			std::array<CharT, 512> buffer;
+			CharT* position = buffer.data();
+			bool failed = false;
+#ifdef FLOSSY_ENABLE_STATS
+			std::size_t flushed = 0;
+#endif
+
+		public:
+			explicit stream_writer(std::basic_streambuf<CharT, Traits>& streambuf)
+					: streambuf(streambuf)
 			{
-				options.zero_fill = false;
 			}
 
-			if (std::isnan(value))
+			stream_writer(stream_writer const&) = delete;
+			stream_writer& operator=(stream_writer const&) = delete;
+
+			// Pass the buffered characters on to the stream buffer. Returns false
+			// if any characters could not be written so far.
+			bool flush()
 			{
-				options.zero_fill = false;
-				if (options.pos_sign == pos_sign_type::plus)
+				auto const count = std::streamsize(position - buffer.data());
+				if (count && streambuf.sputn(buffer.data(), count) != count)
 				{
-					options.pos_sign = pos_sign_type::space;
+					failed = true;
 				}
+#ifdef FLOSSY_ENABLE_STATS
+				flushed += std::size_t(count);
+#endif
+				position = buffer.data();
+				return !failed;
 			}
 
+#ifdef FLOSSY_ENABLE_STATS
+			// Number of characters written so far
+			std::size_t written() const noexcept
+			{
+				return flushed + std::size_t(position - buffer.data());
+			}
+#endif
+
+			void put(CharT c)
+			{
+				*position++ = c;
+				if (position == buffer.data() + buffer.size())
+				{
+					flush();
+				}
+			}
+
+			template<typename InputIt>
+			void write(InputIt first, InputIt last)
+			{
+				for (auto length = std::distance(first, last); length > 0;)
+				{
+					auto const count = std::min<std::ptrdiff_t>(length,
+							buffer.data() + buffer.size() - position);
+					position = std::copy_n(first, count, position);
+					std::advance(first, count);
+					length -= count;
+
+					if (position == buffer.data() + buffer.size())
+					{
+						flush();
+					}
+				}
+			}
+
+			void fill(std::size_t count, CharT c)
+			{
+				while (count > 0)
+				{
+					auto const fill_count = std::min(count,
+							std::size_t(buffer.data() + buffer.size() - position));
+					position = std::fill_n(position, fill_count, c);
+					count -= fill_count;
+
+					if (position == buffer.data() + buffer.size())
+					{
+						flush();
+					}
+				}
+			}
+		};
+
+
+		// Output iterator writing to a stream_writer
+		template<typename CharT, typename Traits>
+		class stream_iterator
+		{
+			stream_writer<CharT, Traits>* writer;
+
+		public:
+			using iterator_category = std::output_iterator_tag;
+			using value_type = void;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = void;
+
+			explicit stream_iterator(stream_writer<CharT, Traits>& writer) noexcept
+					: writer(&writer)
+			{
+			}
+
+			stream_iterator& operator*() noexcept
+			{
+				return *this;
+			}
+
+			stream_iterator& operator=(CharT c)
+			{
+				writer->put(c);
+				return *this;
+			}
+
+			stream_iterator& operator++() noexcept
+			{
+				return *this;
+			}
+
+			stream_iterator operator++(int) noexcept
+			{
+				return *this;
+			}
+
+			template<typename InputIt>
+			stream_iterator write(InputIt first, InputIt last) const
+			{
+				writer->write(first, last);
+				return *this;
+			}
+
+			stream_iterator fill(std::size_t count, CharT c) const
+			{
+				writer->fill(count, c);
+				return *this;
+			}
+		};
+
+
+		// Output iterator writing to a character array, used by static_format.
+		// Unlike the standard algorithms (before C++20), all of its functions
+		// can be evaluated at compile time. Writing past the end is an error.
+		template<typename CharT>
+		class static_writer
+		{
+			CharT* position;
+			CharT* last;
+
+		public:
+			using iterator_category = std::output_iterator_tag;
+			using value_type = void;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = void;
+
+			constexpr static_writer(CharT* first, CharT* last) noexcept
+					: position(first), last(last)
+			{
+			}
+
+			// Position the next character is written to
+			constexpr CharT* get() const noexcept
+			{
+				return position;
+			}
+
+			constexpr static_writer& operator*() noexcept
+			{
+				return *this;
+			}
+
+			constexpr static_writer& operator=(CharT c)
+			{
+				if (position == last)
+				{
+					raise_error("static_format capacity exceeded");
+				}
+				*position = c;
+				return *this;
+			}
+
+			constexpr static_writer& operator++() noexcept
+			{
+				++position;
+				return *this;
+			}
+
+			constexpr static_writer operator++(int) noexcept
+			{
+				static_writer const previous = *this;
+				++position;
+				return previous;
+			}
+
+			template<typename InputIt>
+			constexpr static_writer write(InputIt first, InputIt end) const
+			{
+				static_writer result = *this;
+				for (; first != end; ++first)
+				{
+					*result++ = CharT(*first);
+				}
+				return result;
+			}
+
+			constexpr static_writer fill(std::size_t count, CharT c) const
+			{
+				static_writer result = *this;
+				for (; count; --count)
+				{
+					*result++ = c;
+				}
+				return result;
+			}
+		};
+
+
+		// Output iterators providing their own write and fill functions for
+		// bulk output
+		template<typename OutIt>
+		constexpr bool is_bulk_writer = is_truncating_iterator<OutIt>;
+
+		template<typename CharT, typename Traits>
+		constexpr bool is_bulk_writer<stream_iterator<CharT, Traits>> = true;
+
+		template<typename CharT>
+		constexpr bool is_bulk_writer<static_writer<CharT>> = true;
+
+
+		template<typename OutIt>
+		constexpr bool is_static_writer = false;
+
+		template<typename CharT>
+		constexpr bool is_static_writer<static_writer<CharT>> = true;
+
+
+		// Output iterators of strings and vectors, which can be appended to in bulk
+		template<typename OutIt>
+		constexpr bool is_container_inserter = false;
+
+		template<typename CharT, typename Traits, typename Allocator>
+		constexpr bool is_container_inserter<
+				std::back_insert_iterator<std::basic_string<CharT, Traits, Allocator>>> = true;
+
+		template<typename T, typename Allocator>
+		constexpr bool is_container_inserter<std::back_insert_iterator<std::vector<T, Allocator>>> = true;
+
+
+		// Output iterators of memory buffers, which are appended to in bulk
+		template<typename OutIt>
+		constexpr bool is_memory_buffer_inserter = false;
+
+		template<typename CharT, std::size_t InlineN>
+		constexpr bool is_memory_buffer_inserter<
+				std::back_insert_iterator<basic_memory_buffer<CharT, InlineN>>> = true;
+
+
+		// The container a back_insert_iterator appends to. The standard only
+		// makes it accessible to derived classes.
+		template<typename Container>
+		Container& inserter_container(std::back_insert_iterator<Container> out)
+		{
+			struct access : std::back_insert_iterator<Container>
+			{
+				explicit access(std::back_insert_iterator<Container> out)
+						: std::back_insert_iterator<Container>(out)
+				{
+				}
+
+				Container& get() const
+				{
+					return *this->container;
+				}
+			};
+
+			return access(out).get();
+		}
+
+
+		// Write the characters from first to last to the output iterator. Strings
+		// and vectors are appended to in one go instead of one push_back per
+		// character. For pointers, std::copy already turns into a memmove.
+		template<typename OutIt, typename InputIt>
+		constexpr OutIt write_chars(OutIt out, InputIt first, InputIt last)
+		{
+			if constexpr (is_counting_iterator<OutIt>)
+			{
+				return out + std::size_t(std::distance(first, last));
+			}
+			else if constexpr (is_bulk_writer<OutIt>)
+			{
+				return out.write(first, last);
+			}
+			else if constexpr (is_container_inserter<OutIt>)
+			{
+				auto& container = inserter_container(out);
+				container.insert(container.end(), first, last);
+				return out;
+			}
+			else if constexpr (is_memory_buffer_inserter<OutIt>)
+			{
+				inserter_container(out).append(first, last);
+				return out;
+			}
+			else
+			{
+				return std::copy(first, last, out);
+			}
+		}
+
+
+		// Write count fill characters to the output iterator, in one go where
+		// possible like write_chars.
+		template<typename CharT, typename OutIt>
+		constexpr OutIt write_fill(OutIt out, int count, CharT fill)
+		{
+			if constexpr (is_counting_iterator<OutIt>)
+			{
+				return out + std::size_t(count);
+			}
+			else if constexpr (is_bulk_writer<OutIt>)
+			{
+				return out.fill(std::size_t(count), fill);
+			}
+			else if constexpr (is_container_inserter<OutIt>)
+			{
+				auto& container = inserter_container(out);
+				container.insert(container.end(), std::size_t(count), fill);
+				return out;
+			}
+			else if constexpr (is_memory_buffer_inserter<OutIt>)
+			{
+				inserter_container(out).append(std::size_t(count), fill);
+				return out;
+			}
+			else
+			{
+				return std::fill_n(out, count, fill);
+			}
+		}
+
+
+		// Format string iterators whose characters are stored contiguously, so
+		// they can be scanned through a pointer.
+		template<typename InputIt, typename CharT = typename std::iterator_traits<InputIt>::value_type>
+		constexpr bool is_contiguous_iterator = std::is_pointer<InputIt>::value
+				|| std::is_same<InputIt, typename std::basic_string<CharT>::iterator>::value
+				|| std::is_same<InputIt, typename std::basic_string<CharT>::const_iterator>::value
+				|| std::is_same<InputIt, typename std::basic_string_view<CharT>::const_iterator>::value
+				|| std::is_same<InputIt, typename std::vector<CharT>::iterator>::value
+				|| std::is_same<InputIt, typename std::vector<CharT>::const_iterator>::value;
+
+
+		// True while evaluating a constant expression, where SIMD code cannot run.
+		// Without compiler support it is always false, so static_format cannot
+		// convert hex digits with SSE2 enabled.
+		constexpr bool is_constant_evaluated() noexcept
+		{
+#if defined(__GNUC__) || defined(_MSC_VER)
+			return __builtin_is_constant_evaluated();
+#else
+			return false;
+#endif
+		}
+
+
+		// Index of the lowest set bit of a non-zero mask
+		inline int lowest_bit(unsigned mask)
+		{
+#if defined(__GNUC__)
+			return __builtin_ctz(mask);
+#else
+			int index = 0;
+			for (; !(mask & 1U); mask >>= 1)
+			{
+				++index;
+			}
+			return index;
+#endif
+		}
+
+
+		// Find the first '{' from start to end. Compares 32 (AVX2) or 16 (SSE2)
+		// characters at once where available, the rest is scanned one by one.
+		inline char const* find_brace_bytes(char const* start, char const* const end)
+		{
+#ifdef FLOSSY_AVX2
+			__m256i const braces_256 = _mm256_set1_epi8('{');
+			for (; end - start >= 32; start += 32)
+			{
+				__m256i const chars = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(start));
+				auto const mask = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, braces_256)));
+				if (mask)
+				{
+					return start + lowest_bit(mask);
+				}
+			}
+#endif
+#ifdef FLOSSY_SSE2
+			__m128i const braces = _mm_set1_epi8('{');
+			for (; end - start >= 16; start += 16)
+			{
+				__m128i const chars = _mm_loadu_si128(reinterpret_cast<__m128i const*>(start));
+				auto const mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, braces)));
+				if (mask)
+				{
+					return start + lowest_bit(mask);
+				}
+			}
+#endif
+			return std::find(start, end, '{');
+		}
+
+
+		// Find the first '{' in the format string. Format strings of single byte
+		// characters in contiguous memory are scanned with find_brace_bytes.
+		template<typename InputIt>
+		InputIt find_brace(InputIt start, InputIt const end)
+		{
+			using CharT = typename std::iterator_traits<InputIt>::value_type;
+
+			if constexpr (sizeof(CharT) == 1 && is_contiguous_iterator<InputIt>)
+			{
+				if (start == end)
+				{
+					return end;
+				}
+
+				auto const first = reinterpret_cast<char const*>(&*start);
+				auto const brace = find_brace_bytes(first, first + (end - start));
+				return start + (brace - first);
+			}
+			else
+			{
+				return std::find(start, end, '{');
+			}
+		}
+
+
+		// Number of fill characters needed to pad a value of the given length to
+		// the field width.
+		constexpr int fill_count(conversion_options options, std::ptrdiff_t length)
+		{
+			return options.width > length ? int(options.width - length) : 0;
+		}
+
+
+		// Output string with space padding on the appropriate side
+		template<typename CharT, typename OutIt, typename InputIt>
+		constexpr OutIt
+		format_string(OutIt out, conversion_options options, InputIt start, InputIt end)
+		{
+			int const fill_count = internal::fill_count(options, end - start);
+
+			if constexpr (is_counting_iterator<OutIt>)
+			{
+				return out + std::size_t(end - start + fill_count);
+			}
+			else if (options.alignment == fill_alignment::left)
+			{
+				out = write_fill(out, fill_count, CharT(' '));
+				out = write_chars(out, start, end);
+			}
+			else
+			{
+				out = write_chars(out, start, end);
+				out = write_fill(out, fill_count, CharT(' '));
+			}
+
+			return out;
+		}
+
+
+		// Digits for integer conversions
+		template<typename CharT>
+		constexpr CharT digit_chars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a',
+											'b', 'c', 'd', 'e',
+											'f' };
+
+
+		// All two digit decimal numbers, used to convert decimal numbers two digits
+		// at a time.
+		constexpr char decimal_digit_pairs[] =
+				"00010203040506070809"
+				"10111213141516171819"
+				"20212223242526272829"
+				"30313233343536373839"
+				"40414243444546474849"
+				"50515253545556575859"
+				"60616263646566676869"
+				"70717273747576777879"
+				"80818283848586878889"
+				"90919293949596979899";
+
+
+		// The digit generators below write the digits of an unsigned value
+		// backwards, ending right before 'end', and return a pointer to the first
+		// (most significant) digit.
+
+
+		// Write the decimal digits of the given unsigned value. Takes one division
+		// per two digits instead of one per digit.
+		template<typename CharT, typename ValueT>
+		constexpr CharT* write_decimal_digits(CharT* end, ValueT value)
+		{
+			// Avoid the promotion to int for small types
+			using work_type = std::conditional_t<(sizeof(ValueT) < sizeof(unsigned)), unsigned, ValueT>;
+
+			work_type rest = value;
+
+			while (rest >= 100)
+			{
+				auto const pair = decimal_digit_pairs + (rest % 100) * 2;
+				rest /= 100;
+				*--end = CharT(pair[1]);
+				*--end = CharT(pair[0]);
+			}
+
+			if (rest >= 10)
+			{
+				auto const pair = decimal_digit_pairs + rest * 2;
+				*--end = CharT(pair[1]);
+				*--end = CharT(pair[0]);
+			}
+			else
+			{
+				*--end = CharT('0' + rest);
+			}
+
+			return end;
+		}
+
+
+		// Number of bits needed to represent the given value (0 for 0)
+		template<typename ValueT>
+		constexpr int bit_width(ValueT value)
+		{
+#if defined(__GNUC__)
+			// Wider types (__int128) would be truncated by the cast below.
+			if constexpr (sizeof(ValueT) <= sizeof(unsigned long long))
+			{
+				return value ? std::numeric_limits<unsigned long long>::digits
+							   - __builtin_clzll((unsigned long long) value) : 0;
+			}
+			else
+#endif
+			{
+				int width = 0;
+				for (; value; value >>= 1)
+				{
+					++width;
+				}
+				return width;
+			}
+		}
+
+
+		// Write the digits of the given unsigned value in a base of 2^Shift. Uses
+		// shifts and masks instead of divisions.
+		template<int Shift, typename CharT, typename ValueT>
+		constexpr CharT* write_power_of_two_digits(CharT* end, ValueT value)
+		{
+			constexpr ValueT mask = (1U << Shift) - 1U;
+
+			do
+			{
+				*--end = digit_chars<CharT>[value & mask];
+				value >>= Shift;
+			} while (value);
+
+			return end;
+		}
+
+
+#ifdef FLOSSY_SSE2
+		// Hex digits of a 64 bit value, most significant first. Converts all
+		// nibbles at once.
+		inline void hex_digits_sse2(std::uint64_t value, char (& out)[16])
+		{
+			// Reverse the bytes, so the most significant one comes first
+			value = ((value & 0x00ff00ff00ff00ffULL) << 8) | ((value >> 8) & 0x00ff00ff00ff00ffULL);
+			value = ((value & 0x0000ffff0000ffffULL) << 16) | ((value >> 16) & 0x0000ffff0000ffffULL);
+			value = (value << 32) | (value >> 32);
+
+			__m128i const bytes = _mm_set_epi64x(0, static_cast<long long>(value));
+			__m128i const low_nibble_mask = _mm_set1_epi8(0x0f);
+			__m128i const high = _mm_and_si128(_mm_srli_epi64(bytes, 4), low_nibble_mask);
+			__m128i const low = _mm_and_si128(bytes, low_nibble_mask);
+			__m128i const nibbles = _mm_unpacklo_epi8(high, low);
+
+			// '0' + nibble, plus the distance from '9' + 1 to 'a' for nibbles above 9
+			__m128i const letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)),
+					_mm_set1_epi8('a' - '9' - 1));
+			__m128i const chars = _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+		}
+
+
+		template<typename CharT, typename ValueT>
+		CharT* write_hex_digits_sse2(CharT* end, ValueT value)
+		{
+			char hex[16];
+			hex_digits_sse2(value, hex);
+
+			int const count = std::max((bit_width(value) + 3) / 4, 1);
+			CharT* const begin = end - count;
+			std::copy(hex + 16 - count, hex + 16, begin);
+			return begin;
+		}
+#endif
+
+
+		// Write hex digits. 32 and 64 bit values are converted in one go with SSE2
+		// where available, except in constant expressions.
+		template<typename CharT, typename ValueT>
+		constexpr CharT* write_hex_digits(CharT* end, ValueT value)
+		{
+#ifdef FLOSSY_SSE2
+			if constexpr (sizeof(ValueT) >= 4 && sizeof(ValueT) <= 8)
+			{
+				if (!is_constant_evaluated())
+				{
+					return write_hex_digits_sse2(end, value);
+				}
+			}
+#endif
+			return write_power_of_two_digits<4>(end, value);
+		}
+
+
+		// Write the digits of the given unsigned value in the base selected by format.
+		template<typename CharT, typename ValueT>
+		constexpr CharT* write_digits(CharT* end, ValueT value, conversion_format format)
+		{
+			static_assert(std::is_unsigned<ValueT>::value,
+					"ValueT must be unsigned in write_digits");
+
+			switch (format)
+			{
+			case conversion_format::hex:
+				return write_hex_digits(end, value);
+			case conversion_format::octal:
+				return write_power_of_two_digits<3>(end, value);
+			case conversion_format::binary:
+				return write_power_of_two_digits<1>(end, value);
+			default:
+				return write_decimal_digits(end, value);
+			}
+		}
+
+
+		// Powers of ten that fit into 64 bits, used to count decimal digits
+		constexpr std::uint64_t powers_of_ten[] = {
+				1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+				100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+				10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+				10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+				10000000000000000000ULL
+		};
+
+
+		// Number of digits of the given unsigned value in the base selected by
+		// format. Computed from the bit width, without any divisions.
+		template<typename ValueT>
+		constexpr int count_digits(ValueT value, conversion_format format)
+		{
+			int const bits = bit_width(value);
+
+			switch (format)
+			{
+			case conversion_format::hex:
+				return bits ? (bits + 3) / 4 : 1;
+			case conversion_format::octal:
+				return bits ? (bits + 2) / 3 : 1;
+			case conversion_format::binary:
+				return bits ? bits : 1;
+			default:
+				if constexpr (sizeof(ValueT) <= sizeof(std::uint64_t))
+				{
+					// bits * log10(2) is the number of digits, or one more
+					int const estimate = (bits * 1233) >> 12;
+					return value ? estimate + (std::uint64_t(value) >= powers_of_ten[estimate]) : 1;
+				}
+				else
+				{
+					// Wider than the table of powers of ten (__int128)
+					int count = 1;
+					for (; value >= 10; value /= 10)
+					{
+						++count;
+					}
+					return count;
+				}
+			}
+		}
+
+
+		// Holds the characters of a string with the appropriate size for all numbers
+		template<typename CharT, std::size_t Bits = std::numeric_limits<std::uintmax_t>::digits>
+		struct digit_buffer
+		{
+			// Enough space for the given number of bits in binary representation
+			// and thus in all bases. The default covers all standard integer types,
+			// generate_digits selects more for wider ones (__int128).
+			std::array<CharT, Bits> digits{};
+			int count = 0;
+
+
+			// The digits are stored right aligned, in output order.
+			constexpr CharT const* begin() const
+			{
+				return digits.data() + digits.size() - count;
+			}
+
+
+			constexpr CharT const* end() const
+			{
+				return digits.data() + digits.size();
+			}
+
+
+			// Copy the accumulated characters to the output iterator
+			template<typename OutIt>
+			constexpr OutIt output(OutIt out) const
+			{
+				return write_chars(out, begin(), end());
+			}
+		};
+
+
+		// Generate the digit characters for the given unsigned value
+		template<typename CharT, typename ValueT>
+		constexpr auto generate_digits(ValueT value, conversion_format const& format)
+		{
+			digit_buffer<CharT, std::max(sizeof(ValueT) * std::numeric_limits<unsigned char>::digits,
+					std::size_t(std::numeric_limits<std::uintmax_t>::digits))> digits;
+			CharT* const end = digits.digits.data() + digits.digits.size();
+			digits.count = int(end - write_digits(end, value, format));
+			return digits;
+		}
+
+
+		// The sign character to output when formatting a number
+		enum class sign_character
+		{
+			none,
+			space,
+			plus,
+			minus
+		};
+
+
+		// Write the given sign to the iterator
+		template<typename CharT, typename OutIt>
+		constexpr OutIt write_sign(OutIt out, sign_character sign)
+		{
+			if (sign != sign_character::none)
+			{
+				*out++ = sign == sign_character::space ? CharT(' ')
+						: sign == sign_character::plus ? CharT('+') : CharT('-');
+			}
+
+			return out;
+		}
+
+
+		// Output the given sign to the iterator. Not inlined: for inserters the
+		// write is a push_back, and every integer and float formatter would get
+		// a copy of it.
+		template<typename CharT, typename OutIt>
+#if defined(__GNUC__)
+		__attribute__((noinline))
+#elif defined(_MSC_VER)
+		__declspec(noinline)
+#endif
+		OutIt output_sign(OutIt out, sign_character sign)
+		{
+			return write_sign<CharT>(out, sign);
+		}
+
+
+		// Output values given by out_func to the output iterator and add padding and
+		// sign characters. out_func is called with the output iterator positioned
+		// after the padding and sign characters preceding the value.
+		template<typename CharT, typename OutIt, typename DigitOutFunc>
+		constexpr OutIt output_padded_with_sign(
+				OutIt out, DigitOutFunc out_func, int digit_count,
+				conversion_options options,
+				sign_character sign)
+		{
+			int const fill_count = internal::fill_count(options,
+					digit_count + (sign == sign_character::none ? 0 : 1));
+
+			const auto fill = options.zero_fill ? CharT('0') : CharT(' ');
+
+			// The sign and the value are output in one place only, so inlining
+			// this does not copy out_func for every alignment.
+			if (options.alignment == fill_alignment::left)
+			{
+				out = write_fill(out, fill_count, fill);
+			}
+
+			if constexpr (std::is_pointer<OutIt>::value || is_static_writer<OutIt>)
+			{
+				out = write_sign<CharT>(out, sign);
+			}
+			else
+			{
+				out = output_sign<CharT>(out, sign);
+			}
+
+			if (options.alignment == fill_alignment::intern)
+			{
+				out = write_fill(out, fill_count, fill);
+			}
+
+			out = out_func(out);
+
+			if (options.alignment == fill_alignment::right)
+			{
+				out = write_fill(out, fill_count, fill);
+			}
+
+			return out;
+		}
+
+
+		// Format a decomposed integer with fill characters and sign
+		template<typename OutIt, typename CharT, std::size_t Bits>
+		constexpr OutIt output_integer(
+				OutIt out, digit_buffer<CharT, Bits> const& digits, conversion_options options,
+				sign_character sign)
+		{
+			auto out_func = [&](OutIt out)
+			{
+				return digits.output(out);
+			};
+
+			return output_padded_with_sign<CharT>(out, out_func, digits.count,
+					options, sign);
+		}
+
+
+		// Get the sign character required to display the given sign with the given
+		// representation of positive numbers
+		constexpr sign_character sign_from_format(const bool neg, const pos_sign_type pos)
+		{
+			if (neg)
+			{
+				return sign_character::minus;
+			}
+
+			switch (pos)
+			{
+			case pos_sign_type::plus:
+				return sign_character::plus;
+			case pos_sign_type::space:
+				return sign_character::space;
+			default:
+				return sign_character::none;
+			}
+		}
+
+
+		// Format an unsigned integer without validity checks for given flags with
+		// given sign and options.
+		template<typename CharT, typename OutIt, typename ValueT>
+		typename std::enable_if<
+				std::is_integral<ValueT>::value && std::is_unsigned<ValueT>::value, OutIt>::type
+		format_integer_unchecked(OutIt out, ValueT value, bool negative,
+				conversion_options options)
+		{
+			// Special case: Conversion to character requested
+			if (options.format == conversion_format::character)
+			{
+				*out++ = CharT(value);
+			}
+			else if constexpr (is_counting_iterator<OutIt>)
+			{
+				// Only the size is needed, which follows from the digit count.
+				int const count = count_digits(value, options.format)
+								  + (sign_from_format(negative, options.pos_sign) != sign_character::none);
+
+				out = out + std::size_t(count + fill_count(options, count));
+			}
+			else if constexpr (std::is_same<OutIt, CharT*>::value)
+			{
+				// Contiguous output: count the digits first, then write them directly to
+				// their final position.
+				int const count = count_digits(value, options.format);
+
+				auto out_func = [&](OutIt out)
+				{
+					write_digits(out + count, value, options.format);
+					return out + count;
+				};
+
+				out = output_padded_with_sign<CharT>(out, out_func, count, options,
+						sign_from_format(negative, options.pos_sign));
+			}
+			else
+			{
+				auto const digits = generate_digits<CharT>(value, options.format);
+
+				if (options.is_default())
+				{
+					// Plain "{}": no padding, only a minus sign.
+					if (negative)
+					{
+						*out++ = CharT('-');
+					}
+
+					out = digits.output(out);
+				}
+				else
+				{
+					out = output_integer(out, digits, options,
+							sign_from_format(negative, options.pos_sign));
+				}
+			}
+
+			return out;
+		}
+
+
+		// Format unsigned integer with checks for flag validity with given sign and options.
+		template<typename CharT, typename OutIt, typename ValueT>
+		constexpr typename std::enable_if<
+				std::is_integral<ValueT>::value && std::is_unsigned<ValueT>::value, OutIt>::type
+		format_integer(OutIt out, ValueT value, bool negative, conversion_options options)
+		{
+			if (options.alignment != fill_alignment::intern)
+			{
+				options.zero_fill = false;
+			}
+
+			if constexpr (is_static_writer<OutIt>)
+			{
+				// At compile time. format_integer_unchecked is not constexpr, so it
+				// is not declared inline and its callers stay small.
+				if (options.format == conversion_format::character)
+				{
+					*out++ = CharT(value);
+					return out;
+				}
+
+				return output_integer(out, generate_digits<CharT>(value, options.format), options,
+						sign_from_format(negative, options.pos_sign));
+			}
+			else
+			{
+				return format_integer_unchecked<CharT>(out, value, negative, options);
+			}
+		}
+
+
+		// Absolute value of given value as the unsigned type with same width as
+		// input type (this allows // getting the absolute value of the lowest integer
+		// without overflow).
+		template<typename ValueT>
+		constexpr typename std::make_unsigned<ValueT>::type make_positive(ValueT value)
+		{
+			if (value >= 0)
+			{
+				return static_cast<typename std::make_unsigned<ValueT>::type>(value);
+			}
+			else
+			{
+				return ~(static_cast<typename std::make_unsigned<ValueT>::type>(value) - 1U);
+			}
+		}
+
+		// String formatter for C-Strings
+		template<typename CharT, typename OutIt>
+		constexpr OutIt format_element(OutIt out, conversion_options options, CharT const* value)
+		{
+			return format_string<CharT>(out, options, value,
+					value + std::char_traits<CharT>::length(value));
+		}
+
+
+		// String formatter for C++ strings
+		template<typename CharT, typename OutIt>
+		constexpr OutIt format_element(OutIt out, conversion_options options,
+				std::basic_string_view<CharT> value)
+		{
+			return format_string<CharT>(out, options, value.begin(), value.end());
+		}
+
+
+		// If there are not value left to convert, just copy the rest of the input.
+		// Ignore further conversion specifiers.
+		template<typename OutIt, typename InputIt>
+		OutIt format_it(OutIt out, InputIt start, InputIt const end)
+		{
+			return write_chars(out, start, end);
+		}
+
+
+		// Formatter function for unsigned integers
+		template<typename CharT, typename OutIt, typename ValueT>
+		constexpr typename std::enable_if<
+				std::is_integral<ValueT>::value && std::is_unsigned<ValueT>::value, OutIt>::type
+		format_element(OutIt out, conversion_options options, ValueT value)
+		{
+			return format_integer<CharT>(out, value, false, options);
+		}
+
+
+		// Formatter function for a signed integer. Converts the given number bitwise to
+		// an unsigned value if the requested conversion is _not_ decimal. For decimal,
+		// it passes the absolute value and sign bit appropriately
+		template<typename CharT, typename OutIt, typename ValueT>
+		constexpr typename std::enable_if<
+				std::is_integral<ValueT>::value && std::is_signed<ValueT>::value, OutIt>::type
+		format_element(OutIt out, conversion_options options, ValueT value)
+		{
+			if (options.format != conversion_format::normal and
+				options.format != conversion_format::decimal)
+			{
+				return format_integer<CharT>(out,
+						static_cast<typename std::make_unsigned<ValueT>::type>(value), false,
+						options);
+			}
+			else
+			{
+				return format_integer<CharT>(out, make_positive(value), value < 0, options);
+			}
+		}
+
+
+// Formatter function for floating point numbers.
+
+		// Floats are only zero filled if they are finite and aligned internally, and
+		// NaN never gets a plus sign, as it has no sign to speak of.
+		template<typename ValueT>
+		conversion_options float_options(conversion_options options, ValueT value)
+		{
+			if (options.alignment != fill_alignment::intern || std::isinf(value))
+			{
+				options.zero_fill = false;
+			}
+
+			if (std::isnan(value))
+			{
+				options.zero_fill = false;
+				if (options.pos_sign == pos_sign_type::plus)
+				{
+					options.pos_sign = pos_sign_type::space;
+				}
+			}
+
+			return options;
+		}
+
+
+		// Stream buffer appending to a memory buffer
+		template<typename CharT, std::size_t InlineN>
+		class memory_buffer_streambuf : public std::basic_streambuf<CharT>
+		{
+			using int_type = typename std::basic_streambuf<CharT>::int_type;
+			using traits_type = typename std::basic_streambuf<CharT>::traits_type;
+
+			basic_memory_buffer<CharT, InlineN>& buffer;
+
+		public:
+			explicit memory_buffer_streambuf(basic_memory_buffer<CharT, InlineN>& buffer)
+					: buffer(buffer)
+			{
+			}
+
+		protected:
+			int_type overflow(int_type c) override
+			{
+				if (!traits_type::eq_int_type(c, traits_type::eof()))
+				{
+					buffer.push_back(traits_type::to_char_type(c));
+				}
+				return traits_type::not_eof(c);
+			}
+
+			std::streamsize xsputn(CharT const* s, std::streamsize count) override
+			{
+				buffer.append(s, s + count);
+				return count;
+			}
+		};
+
+
+		// Precision and notation of the shortest representation of a positive
+		// value that reads back to the same value ('r' type). Like std::to_chars,
+		// fixed notation is used unless scientific notation is shorter. The
+		// number of digits is searched by converting and reading back with string
+		// streams, which allocates, but this is only used by the string stream
+		// method and as fallback.
+		template<typename ValueT>
+		std::pair<int, std::ios::fmtflags> shortest_float_format(ValueT value)
+		{
+			if (!std::isfinite(value))
+			{
+				return { 0, std::ios::fixed };
+			}
+
+			std::ostringstream written;
+			written.flags(std::ios::scientific);
+			std::istringstream read;
+
+			int precision = 0;
+			for (; precision < std::numeric_limits<ValueT>::max_digits10 - 1; ++precision)
+			{
+				written.str({});
+				written.precision(precision);
+				written << value;
+
+				ValueT result{};
+				read.clear();
+				read.str(written.str());
+				// Values out of range read as the largest value, but fail
+				if (read >> result && result == value)
+				{
+					break;
+				}
+			}
+
+			auto const text = written.str();
+			int const exponent = std::stoi(text.substr(text.find('e') + 1));
+			int const fixed_precision = std::max(precision - exponent, 0);
+			int const fixed_length = std::max(exponent, 0) + 1
+									 + (fixed_precision > 0 ? fixed_precision + 1 : 0);
+
+			if (int(text.size()) < fixed_length)
+			{
+				return { precision, std::ios::scientific };
+			}
+			return { fixed_precision, std::ios::fixed };
+		}
+
+
+		// This method used C++ streams to convert float values. That means it is
+		// precise and easy to implement. The characters are collected in a
+		// memory buffer on the stack, so only values with a very long output
+		// allocate memory, but streams are still slower than the other
+		// alternatives.
+		//
+		// Callers that never pass the 'r' type set Shortest to false, so the
+		// search for the shortest representation is not compiled in.
+		template<typename CharT, bool Shortest = true, typename OutIt, typename ValueT>
+		OutIt format_float_sstream(OutIt out, conversion_options options, ValueT value)
+		{
+			options = float_options(options, value);
+
+			std::pair<int, std::ios::fmtflags> float_format(options.precision,
+					options.format != conversion_format::scientific_float
+					? std::ios::fixed
+					: std::ios::scientific);
+
+			if constexpr (Shortest)
+			{
+				if (options.format == conversion_format::shortest_float)
+				{
+					float_format = shortest_float_format(std::abs(value));
+				}
+			}
+
+			// Format as char string, convert to wider character types later (in write_chars).
+			// This works with char32_t, while using a basic_ostream<char32_t> doesn't.
+			// I did not investigate further, why it doesn't work. :)
+			basic_memory_buffer<char, 128> chars;
+			memory_buffer_streambuf<char, 128> streambuf(chars);
+			std::ostream buffer(&streambuf);
+			buffer.precision(float_format.first);
+			buffer.flags(float_format.second);
+			buffer << std::abs(value);
+
+			auto out_func = [&](OutIt out)
+			{
+				return write_chars(out, chars.begin(), chars.end());
+			};
+
+			// The method std::signbit determines if the given floating point number arg is negative.
+			// Return value: true if arg is negative, false otherwise.
+			bool const isNegative = std::signbit(value);
+
+			return output_padded_with_sign<CharT>(out, out_func, int(chars.size()), options,
+					sign_from_format(isNegative, options.pos_sign));
+		}
+
+
+#if FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_SSTREAM
+
+		template<typename CharT, typename OutIt, typename ValueT>
+		typename std::enable_if<std::is_floating_point<ValueT>::value, OutIt>::type
+		format_element(OutIt out, conversion_options options, ValueT value)
+		{
+			return format_float_sstream<CharT>(out, options, value);
+		}
+
+#elif FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_FAST
+		// This method multiplies the value by 10^precision, rounds it to a 64 bit
+		// integer and outputs that with the integer formatting functions. That's a
+		// lot faster than the other methods. The powers of ten up to 10^15 are
+		// exact, so the product is off by at most half a unit in its last place.
+		// Unless the fractional part of the product is closer to one half than
+		// that, the rounding direction is known and the output is the same as
+		// with the string stream method.
+		//
+		// Only fixed notation is converted this way, and only if the scaled value
+		// is below 2^52, where its fractional part is still represented.
+		// Everything else (scientific and shortest notation, large values and
+		// precisions, values too close to halfway between two outputs, NaN and
+		// infinity) falls back to the precise string stream method.
+
+		constexpr double fast_float_powers_of_ten[] = {
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+		};
+
+
+		template<typename CharT, typename OutIt, typename ValueT>
+		typename std::enable_if<std::is_floating_point<ValueT>::value, OutIt>::type
+		format_element(OutIt out, conversion_options options, ValueT value)
+		{
+			int const precision = options.precision;
+			double const scaled = precision < 16
+								  ? std::abs(double(value)) * fast_float_powers_of_ten[precision]
+								  : 0.0;
+
+			if (options.format == conversion_format::scientific_float
+				|| options.format == conversion_format::shortest_float || precision >= 16
+				|| !(scaled < 0x1p52))
+			{
+				return format_float_sstream<CharT>(out, options, value);
+			}
+
+			// Both are exact below 2^52. The error of the product is at most
+			// scaled * 2^-53.
+			double const integral_part = std::floor(scaled);
+			double const fraction_part = scaled - integral_part;
+			if (std::abs(fraction_part - 0.5) <= scaled * 0x1p-53)
+			{
+				return format_float_sstream<CharT>(out, options, value);
+			}
+
+			options = float_options(options, value);
+
+			auto const rounded = std::uint64_t(integral_part) + (fraction_part > 0.5);
+			auto const unit = std::uint64_t(fast_float_powers_of_ten[precision]);
+
+			auto const integral = generate_digits<CharT>(rounded / unit, conversion_format::decimal);
+			auto const fraction = generate_digits<CharT>(rounded % unit, conversion_format::decimal);
+
+			auto out_func = [&](OutIt out)
+			{
+				out = integral.output(out);
+				if (precision > 0)
+				{
+					*out++ = CharT('.');
+					out = write_fill(out, precision - fraction.count, CharT('0'));
+					out = fraction.output(out);
+				}
+				return out;
+			};
+
+			return output_padded_with_sign<CharT>(out, out_func,
+					integral.count + (precision > 0 ? precision + 1 : 0), options,
+					sign_from_format(std::signbit(value), options.pos_sign));
+		}
+
+#elif FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_GRISU
+		// This method converts floats with integer arithmetic only, so it never
+		// allocates memory and does not depend on the locale. The digits are
+		// generated with Grisu3 (Loitsch, "Printing Floating-Point Numbers Quickly
+		// and Accurately with Integers"), which scales the value by a cached power
+		// of ten using 64 bit integers. As the scaling is inexact, Grisu3 checks
+		// its result against the error bounds and gives up if it cannot prove it
+		// correct, which happens for about 0.5% of the values and for values
+		// with more than about 17 significant digits. These are converted exactly
+		// on fixed size big integers as described by Steele & White and Burger &
+		// Dybvig ("Printing Floating-Point Numbers Quickly and Accurately"), so
+		// the output is the same as with the string stream method.
+		//
+		// The 'r' type generates the shortest representation that reads back to
+		// the same value directly from the bounds of the rounding interval.
+		//
+		// long double is still converted using string streams.
+
+		// Unsigned integer with a fixed number of bits, large enough for the exact
+		// value of every double multiplied with the powers of ten needed to print it.
+		class big_integer
+		{
+			static constexpr int capacity = 40;
+
+			std::array<std::uint32_t, capacity> words{};
+			int count = 0;
+
+		public:
+			explicit big_integer(std::uint64_t value = 0)
+			{
+				while (value)
+				{
+					words[count++] = std::uint32_t(value);
+					value >>= 32;
+				}
+			}
+
+
+			bool is_zero() const
+			{
+				return count == 0;
+			}
+
+
+			void multiply(std::uint32_t factor)
+			{
+				std::uint64_t carry = 0;
+				for (int i = 0; i < count; ++i)
+				{
+					carry += std::uint64_t(words[i]) * factor;
+					words[i] = std::uint32_t(carry);
+					carry >>= 32;
+				}
+				if (carry)
+				{
+					words[count++] = std::uint32_t(carry);
+				}
+			}
+
+
+			void multiply_pow10(int exponent)
+			{
+				for (; exponent >= 9; exponent -= 9)
+				{
+					multiply(1000000000U);
+				}
+
+				std::uint32_t factor = 1;
+				for (; exponent > 0; --exponent)
+				{
+					factor *= 10;
+				}
+				multiply(factor);
+			}
+
+
+			void shift_left(int bits)
+			{
+				if (count == 0)
+				{
+					return;
+				}
+
+				int const word_shift = bits / 32;
+				int const bit_shift = bits % 32;
+
+				if (bit_shift)
+				{
+					words[count] = 0;
+					for (int i = count; i > 0; --i)
+					{
+						words[i] = (words[i] << bit_shift) | (words[i - 1] >> (32 - bit_shift));
+					}
+					words[0] <<= bit_shift;
+					count += words[count] ? 1 : 0;
+				}
+
+				if (word_shift)
+				{
+					for (int i = count - 1; i >= 0; --i)
+					{
+						words[i + word_shift] = words[i];
+					}
+					std::fill_n(words.begin(), word_shift, 0U);
+					count += word_shift;
+				}
+			}
+
+
+			void add(big_integer const& other)
+			{
+				std::uint64_t carry = 0;
+				int const n = std::max(count, other.count);
+				for (int i = 0; i < n; ++i)
+				{
+					carry += std::uint64_t(i < count ? words[i] : 0) + (i < other.count ? other.words[i] : 0);
+					words[i] = std::uint32_t(carry);
+					carry >>= 32;
+				}
+				count = n;
+				if (carry)
+				{
+					words[count++] = std::uint32_t(carry);
+				}
+			}
+
+
+			// Subtract a value that is not larger than this one.
+			void subtract(big_integer const& other)
+			{
+				std::int64_t borrow = 0;
+				for (int i = 0; i < count; ++i)
+				{
+					borrow += std::int64_t(words[i]) - (i < other.count ? other.words[i] : 0);
+					words[i] = std::uint32_t(borrow);
+					borrow = borrow < 0 ? -1 : 0;
+				}
+				while (count > 0 && words[count - 1] == 0)
+				{
+					--count;
+				}
+			}
+
+
+			// Subtract other * factor, which must not be larger than this value.
+			void subtract_times(big_integer const& other, std::uint32_t factor)
+			{
+				std::uint64_t carry = 0;
+				std::int64_t borrow = 0;
+				for (int i = 0; i < count; ++i)
+				{
+					carry += std::uint64_t(i < other.count ? other.words[i] : 0) * factor;
+					borrow += std::int64_t(words[i]) - std::int64_t(std::uint32_t(carry));
+					carry >>= 32;
+					words[i] = std::uint32_t(borrow);
+					borrow = borrow < 0 ? -1 : 0;
+				}
+				while (count > 0 && words[count - 1] == 0)
+				{
+					--count;
+				}
+			}
+
+
+			friend int compare(big_integer const& a, big_integer const& b)
+			{
+				if (a.count != b.count)
+				{
+					return a.count < b.count ? -1 : 1;
+				}
+				for (int i = a.count; i > 0; --i)
+				{
+					if (a.words[i - 1] != b.words[i - 1])
+					{
+						return a.words[i - 1] < b.words[i - 1] ? -1 : 1;
+					}
+				}
+				return 0;
+			}
+
+
+			// Compare a + b with c.
+			friend int compare_sum(big_integer a, big_integer const& b, big_integer const& c)
+			{
+				a.add(b);
+				return compare(a, c);
+			}
+
+
+			// Multiply by ten and return the integral part of the result divided by
+			// divisor, keeping the remainder. The value must be less than divisor.
+			int next_digit(big_integer const& divisor)
+			{
+				multiply(10);
+
+				// Estimate the digit from the highest words. The estimate is never
+				// too large, and at most a few subtractions correct it.
+				int digit = 0;
+				int const top = divisor.count - 1;
+				if (count >= divisor.count)
+				{
+					std::uint64_t const high = (count > divisor.count ? std::uint64_t(words[top + 1]) << 32 : 0)
+											   | words[top];
+					auto const estimate = std::uint32_t(high / (std::uint64_t(divisor.words[top]) + 1));
+					if (estimate)
+					{
+						subtract_times(divisor, estimate);
+						digit = int(estimate);
+					}
+				}
+
+				while (compare(*this, divisor) >= 0)
+				{
+					subtract(divisor);
+					++digit;
+				}
+				return digit;
+			}
+		};
+
+
+		// Decimal digits of a positive float: the value is 0.d0 d1 d2 ... * 10^exponent.
+		// Digits after the last stored one are zero.
+		struct decimal_digits
+		{
+			// The exact value of a double has at most 767 significant digits.
+			std::array<char, 800> digits;
+			int count = 0;
+			int exponent = 0;
+
+
+			// The digit with the place value 10^place
+			char at(int place) const
+			{
+				int const index = exponent - 1 - place;
+				return index >= 0 && index < count ? char('0' + digits[index]) : '0';
+			}
+
+
+			// Add one to the last digit, carrying over as needed
+			void round_up()
+			{
+				for (int i = count; i > 0; --i)
+				{
+					if (++digits[i - 1] < 10)
+					{
+						return;
+					}
+					digits[i - 1] = 0;
+				}
+
+				// All digits were nines (or there were none at all)
+				std::copy_backward(digits.begin(), digits.begin() + count, digits.begin() + count + 1);
+				digits[0] = 1;
+				++count;
+				++exponent;
+			}
+
+
+			// Drop trailing zero digits
+			void trim()
+			{
+				while (count > 0 && digits[count - 1] == 0)
+				{
+					--count;
+				}
+			}
+		};
+
+
+		// A positive, finite float split into mantissa * 2^exponent
+		struct binary_float
+		{
+			std::uint64_t mantissa = 0;
+			int exponent = 0;
+			// True for powers of two, where the next lower float is closer than the
+			// next higher one.
+			bool closer_lower_boundary = false;
+		};
+
+
+		template<typename ValueT>
+		binary_float decompose_float(ValueT value)
+		{
+			constexpr int digits = std::numeric_limits<ValueT>::digits;
+			constexpr int min_exponent = std::numeric_limits<ValueT>::min_exponent - digits;
+
+			int exponent = 0;
+			ValueT const fraction = std::frexp(value, &exponent);
+
+			binary_float result;
+			result.mantissa = std::uint64_t(std::ldexp(fraction, digits));
+			result.exponent = exponent - digits;
+
+			// Denormals have less significant bits
+			if (result.exponent < min_exponent)
+			{
+				result.mantissa >>= min_exponent - result.exponent;
+				result.exponent = min_exponent;
+			}
+
+			result.closer_lower_boundary = result.mantissa == std::uint64_t(1) << (digits - 1)
+										   && result.exponent > min_exponent;
+			return result;
+		}
+
+
+		// Estimate of the decimal exponent of a positive value, i.e. the smallest
+		// exponent with value < 10^exponent. May be off by one.
+		template<typename ValueT>
+		int estimate_decimal_exponent(ValueT value)
+		{
+			return int(std::ceil(std::log10(value)));
+		}
+
+
+		// Grisu3 fast path
+
+		// Floating point number with a 64 bit significand and no hidden bit,
+		// value == f * 2^e
+		struct diy_fp
+		{
+			std::uint64_t f = 0;
+			int e = 0;
+		};
+
+
+		// Shift the significand left until its highest bit is set
+		inline diy_fp normalize(diy_fp value)
+		{
+			int const shift = std::numeric_limits<std::uint64_t>::digits - bit_width(value.f);
+			return { value.f << shift, value.e - shift };
+		}
+
+
+		// Product rounded to 64 bits, off by at most half a unit in the last place
+		inline diy_fp multiply(diy_fp a, diy_fp b)
+		{
+			constexpr std::uint64_t mask = 0xffffffffU;
+
+			std::uint64_t const ac = (a.f >> 32) * (b.f >> 32);
+			std::uint64_t const bc = (a.f & mask) * (b.f >> 32);
+			std::uint64_t const ad = (a.f >> 32) * (b.f & mask);
+			std::uint64_t const bd = (a.f & mask) * (b.f & mask);
+
+			// Round the lower half
+			std::uint64_t const middle = (bd >> 32) + (ad & mask) + (bc & mask) + (std::uint64_t(1) << 31);
+			return { ac + (ad >> 32) + (bc >> 32) + (middle >> 32), a.e + b.e + 64 };
+		}
+
+
+		// Normalized power of ten, 10^decimal_exponent == significand * 2^binary_exponent
+		struct cached_power
+		{
+			std::uint64_t significand;
+			std::int16_t binary_exponent;
+			std::int16_t decimal_exponent;
+		};
+
+
+		// Every eighth power of ten from 10^-348 to 10^340, rounded to nearest
+		constexpr cached_power cached_powers[] = {
+				{ 0xfa8fd5a0081c0288, -1220, -348 }, { 0xbaaee17fa23ebf76, -1193, -340 },
+				{ 0x8b16fb203055ac76, -1166, -332 }, { 0xcf42894a5dce35ea, -1140, -324 },
+				{ 0x9a6bb0aa55653b2d, -1113, -316 }, { 0xe61acf033d1a45df, -1087, -308 },
+				{ 0xab70fe17c79ac6ca, -1060, -300 }, { 0xff77b1fcbebcdc4f, -1034, -292 },
+				{ 0xbe5691ef416bd60c, -1007, -284 }, { 0x8dd01fad907ffc3c, -980, -276 },
+				{ 0xd3515c2831559a83, -954, -268 }, { 0x9d71ac8fada6c9b5, -927, -260 },
+				{ 0xea9c227723ee8bcb, -901, -252 }, { 0xaecc49914078536d, -874, -244 },
+				{ 0x823c12795db6ce57, -847, -236 }, { 0xc21094364dfb5637, -821, -228 },
+				{ 0x9096ea6f3848984f, -794, -220 }, { 0xd77485cb25823ac7, -768, -212 },
+				{ 0xa086cfcd97bf97f4, -741, -204 }, { 0xef340a98172aace5, -715, -196 },
+				{ 0xb23867fb2a35b28e, -688, -188 }, { 0x84c8d4dfd2c63f3b, -661, -180 },
+				{ 0xc5dd44271ad3cdba, -635, -172 }, { 0x936b9fcebb25c996, -608, -164 },
+				{ 0xdbac6c247d62a584, -582, -156 }, { 0xa3ab66580d5fdaf6, -555, -148 },
+				{ 0xf3e2f893dec3f126, -529, -140 }, { 0xb5b5ada8aaff80b8, -502, -132 },
+				{ 0x87625f056c7c4a8b, -475, -124 }, { 0xc9bcff6034c13053, -449, -116 },
+				{ 0x964e858c91ba2655, -422, -108 }, { 0xdff9772470297ebd, -396, -100 },
+				{ 0xa6dfbd9fb8e5b88f, -369, -92 }, { 0xf8a95fcf88747d94, -343, -84 },
+				{ 0xb94470938fa89bcf, -316, -76 }, { 0x8a08f0f8bf0f156b, -289, -68 },
+				{ 0xcdb02555653131b6, -263, -60 }, { 0x993fe2c6d07b7fac, -236, -52 },
+				{ 0xe45c10c42a2b3b06, -210, -44 }, { 0xaa242499697392d3, -183, -36 },
+				{ 0xfd87b5f28300ca0e, -157, -28 }, { 0xbce5086492111aeb, -130, -20 },
+				{ 0x8cbccc096f5088cc, -103, -12 }, { 0xd1b71758e219652c, -77, -4 },
+				{ 0x9c40000000000000, -50, 4 }, { 0xe8d4a51000000000, -24, 12 },
+				{ 0xad78ebc5ac620000, 3, 20 }, { 0x813f3978f8940984, 30, 28 },
+				{ 0xc097ce7bc90715b3, 56, 36 }, { 0x8f7e32ce7bea5c70, 83, 44 },
+				{ 0xd5d238a4abe98068, 109, 52 }, { 0x9f4f2726179a2245, 136, 60 },
+				{ 0xed63a231d4c4fb27, 162, 68 }, { 0xb0de65388cc8ada8, 189, 76 },
+				{ 0x83c7088e1aab65db, 216, 84 }, { 0xc45d1df942711d9a, 242, 92 },
+				{ 0x924d692ca61be758, 269, 100 }, { 0xda01ee641a708dea, 295, 108 },
+				{ 0xa26da3999aef774a, 322, 116 }, { 0xf209787bb47d6b85, 348, 124 },
+				{ 0xb454e4a179dd1877, 375, 132 }, { 0x865b86925b9bc5c2, 402, 140 },
+				{ 0xc83553c5c8965d3d, 428, 148 }, { 0x952ab45cfa97a0b3, 455, 156 },
+				{ 0xde469fbd99a05fe3, 481, 164 }, { 0xa59bc234db398c25, 508, 172 },
+				{ 0xf6c69a72a3989f5c, 534, 180 }, { 0xb7dcbf5354e9bece, 561, 188 },
+				{ 0x88fcf317f22241e2, 588, 196 }, { 0xcc20ce9bd35c78a5, 614, 204 },
+				{ 0x98165af37b2153df, 641, 212 }, { 0xe2a0b5dc971f303a, 667, 220 },
+				{ 0xa8d9d1535ce3b396, 694, 228 }, { 0xfb9b7cd9a4a7443c, 720, 236 },
+				{ 0xbb764c4ca7a44410, 747, 244 }, { 0x8bab8eefb6409c1a, 774, 252 },
+				{ 0xd01fef10a657842c, 800, 260 }, { 0x9b10a4e5e9913129, 827, 268 },
+				{ 0xe7109bfba19c0c9d, 853, 276 }, { 0xac2820d9623bf429, 880, 284 },
+				{ 0x80444b5e7aa7cf85, 907, 292 }, { 0xbf21e44003acdd2d, 933, 300 },
+				{ 0x8e679c2f5e44ff8f, 960, 308 }, { 0xd433179d9c8cb841, 986, 316 },
+				{ 0x9e19db92b4e31ba9, 1013, 324 }, { 0xeb96bf6ebadf77d9, 1039, 332 },
+				{ 0xaf87023b9bf0ee6b, 1066, 340 },
+		};
+
+		constexpr int cached_powers_offset = 348;
+		constexpr int cached_powers_distance = 8;
+
+		// The scaled value's binary exponent is kept in this range, so its
+		// integral part has at most 32 bits and its fraction at least 32.
+		constexpr int grisu_min_exponent = -60;
+
+
+		// Cached power of ten that scales a value with the given binary exponent
+		// of its normalized significand into the range of grisu_min_exponent.
+		inline cached_power const& grisu_cached_power(int exponent)
+		{
+			int const min_exponent = grisu_min_exponent - (exponent + 64);
+			int const k = int(std::ceil((min_exponent + 63) * 0.30102999566398114));
+			return cached_powers[(cached_powers_offset + k - 1) / cached_powers_distance + 1];
+		}
+
+
+		// The largest power of ten not above value, and its number of digits
+		inline std::pair<std::uint32_t, int> largest_power_of_ten(std::uint32_t value)
+		{
+			std::uint32_t power = 1;
+			int digits = value ? 1 : 0;
+			while (digits < 10 && value / 10 >= power)
+			{
+				power *= 10;
+				++digits;
+			}
+			return { power, digits };
+		}
+
+
+		// Move the last of the shortest digits closer to the scaled value if
+		// possible, and check that the result is within the rounding interval
+		// despite the errors of the scaling. All values are in units of the
+		// current digit's scale: rest is the distance of the digits to the upper
+		// bound, ten_kappa the weight of the last digit.
+		inline bool grisu_round_weed(decimal_digits& result, std::uint64_t distance_high_w,
+				std::uint64_t unsafe_interval, std::uint64_t rest, std::uint64_t ten_kappa,
+				std::uint64_t unit)
+		{
+			std::uint64_t const small_distance = distance_high_w - unit;
+			std::uint64_t const big_distance = distance_high_w + unit;
+
+			while (rest < small_distance && unsafe_interval - rest >= ten_kappa
+				   && (rest + ten_kappa < small_distance
+					   || small_distance - rest >= rest + ten_kappa - small_distance))
+			{
+				--result.digits[result.count - 1];
+				rest += ten_kappa;
+			}
+
+			// Another digit could be closer, within the errors
+			if (rest < big_distance && unsafe_interval - rest >= ten_kappa
+				&& (rest + ten_kappa < big_distance
+					|| big_distance - rest > rest + ten_kappa - big_distance))
+			{
+				return false;
+			}
+
+			return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+		}
+
+
+		// Round the counted digits according to the rest, if the error does not
+		// make the direction uncertain.
+		inline bool grisu_round_weed_counted(decimal_digits& result, std::uint64_t rest,
+				std::uint64_t ten_kappa, std::uint64_t unit)
+		{
+			if (unit >= ten_kappa || ten_kappa - unit <= unit)
+			{
+				return false;
+			}
+
+			if (ten_kappa - rest > rest && ten_kappa - 2 * rest >= 2 * unit)
+			{
+				return true;
+			}
+
+			if (rest > unit && ten_kappa - (rest - unit) <= rest - unit)
+			{
+				result.round_up();
+				return true;
+			}
+
+			return false;
+		}
+
+
+		// Generate the shortest digits that read back to the same value with
+		// Grisu3. Returns false if the result is not guaranteed to be correct.
+		inline bool grisu_shortest_digits(decimal_digits& result, binary_float const& bits)
+		{
+			diy_fp const w = normalize({ bits.mantissa, bits.exponent });
+
+			// Halfway points to the neighbouring floats, with the exponent of w
+			diy_fp const high = normalize({ (bits.mantissa << 1) + 1, bits.exponent - 1 });
+			diy_fp low = bits.closer_lower_boundary
+						 ? diy_fp{ (bits.mantissa << 2) - 1, bits.exponent - 2 }
+						 : diy_fp{ (bits.mantissa << 1) - 1, bits.exponent - 1 };
+			low.f <<= low.e - high.e;
+			low.e = high.e;
+
+			cached_power const& power = grisu_cached_power(w.e);
+			diy_fp const ten_mk{ power.significand, power.binary_exponent };
+			diy_fp const scaled_w = multiply(w, ten_mk);
+			diy_fp const scaled_low = multiply(low, ten_mk);
+			diy_fp const scaled_high = multiply(high, ten_mk);
+
+			// Each product is off by less than one unit, so everything between
+			// too_low and too_high might be within the interval.
+			std::uint64_t unit = 1;
+			std::uint64_t const too_low = scaled_low.f - unit;
+			std::uint64_t const too_high = scaled_high.f + unit;
+			std::uint64_t unsafe_interval = too_high - too_low;
+
+			int const shift = -scaled_w.e;
+			std::uint64_t const one = std::uint64_t(1) << shift;
+			auto integrals = std::uint32_t(too_high >> shift);
+			std::uint64_t fractionals = too_high & (one - 1);
+
+			auto [divisor, kappa] = largest_power_of_ten(integrals);
+			result.count = 0;
+
+			while (kappa > 0)
+			{
+				result.digits[result.count++] = char(integrals / divisor);
+				integrals %= divisor;
+				--kappa;
+
+				std::uint64_t const rest = (std::uint64_t(integrals) << shift) + fractionals;
+				if (rest < unsafe_interval)
+				{
+					result.exponent = result.count + kappa - power.decimal_exponent;
+					return grisu_round_weed(result, too_high - scaled_w.f, unsafe_interval, rest,
+							std::uint64_t(divisor) << shift, unit);
+				}
+				divisor /= 10;
+			}
+
+			for (;;)
+			{
+				fractionals *= 10;
+				unit *= 10;
+				unsafe_interval *= 10;
+
+				result.digits[result.count++] = char(fractionals >> shift);
+				fractionals &= one - 1;
+				--kappa;
+
+				if (fractionals < unsafe_interval)
+				{
+					result.exponent = result.count + kappa - power.decimal_exponent;
+					return grisu_round_weed(result, (too_high - scaled_w.f) * unit, unsafe_interval,
+							fractionals, one, unit);
+				}
+			}
+		}
+
+
+		// Generate the digits like generate_float_digits with Grisu3. Returns
+		// false if the result is not guaranteed to be correctly rounded, which
+		// includes exact halfway cases and values rounding to zero digits.
+		inline bool grisu_counted_digits(decimal_digits& result, binary_float const& bits,
+				int precision, bool fixed)
+		{
+			diy_fp const w = normalize({ bits.mantissa, bits.exponent });
+			cached_power const& power = grisu_cached_power(w.e);
+			diy_fp const scaled_w = multiply(w, { power.significand, power.binary_exponent });
+
+			// The error of scaled_w, in units of the current digit's scale
+			std::uint64_t error = 1;
+
+			int const shift = -scaled_w.e;
+			std::uint64_t const one = std::uint64_t(1) << shift;
+			auto integrals = std::uint32_t(scaled_w.f >> shift);
+			std::uint64_t fractionals = scaled_w.f & (one - 1);
+
+			auto [divisor, kappa] = largest_power_of_ten(integrals);
+
+			// If scaled_w is just below a power of ten while the value is not,
+			// the digits are nines and rounding carries into the next place.
+			int const wanted = fixed ? kappa - power.decimal_exponent + precision : precision;
+			if (wanted <= 0)
+			{
+				return false;
+			}
+
+			result.count = 0;
+
+			while (kappa > 0)
+			{
+				result.digits[result.count++] = char(integrals / divisor);
+				integrals %= divisor;
+				--kappa;
+
+				if (result.count == wanted)
+				{
+					result.exponent = result.count + kappa - power.decimal_exponent;
+					return grisu_round_weed_counted(result,
+							(std::uint64_t(integrals) << shift) + fractionals,
+							std::uint64_t(divisor) << shift, error);
+				}
+				divisor /= 10;
+			}
+
+			while (result.count < wanted && fractionals > error)
+			{
+				fractionals *= 10;
+				error *= 10;
+
+				result.digits[result.count++] = char(fractionals >> shift);
+				fractionals &= one - 1;
+				--kappa;
+			}
+
+			if (result.count != wanted)
+			{
+				return false;
+			}
+
+			result.exponent = result.count + kappa - power.decimal_exponent;
+			return grisu_round_weed_counted(result, fractionals, one, error);
+		}
+
+
+		// Generate the digits of value, correctly rounded (half to even) to the
+		// given number of significant digits, or to the given number of fractional
+		// digits if fixed is true.
+		template<typename ValueT>
+		void generate_float_digits(decimal_digits& result, ValueT value, int precision, bool fixed)
+		{
+			binary_float const bits = decompose_float(value);
+
+			if (grisu_counted_digits(result, bits, precision, fixed))
+			{
+				return;
+			}
+
+			// value == r / s * 10^k
+			big_integer r(bits.mantissa);
+			big_integer s(1);
+
+			if (bits.exponent >= 0)
+			{
+				r.shift_left(bits.exponent);
+			}
+			else
+			{
+				s.shift_left(-bits.exponent);
+			}
+
+			int k = estimate_decimal_exponent(value);
+			if (k >= 0)
+			{
+				s.multiply_pow10(k);
+			}
+			else
+			{
+				r.multiply_pow10(-k);
+			}
+
+			// Fix the estimate, so that 0.1 <= r / s < 1
+			while (compare(r, s) >= 0)
+			{
+				s.multiply(10);
+				++k;
+			}
+			for (;;)
+			{
+				big_integer r10 = r;
+				r10.multiply(10);
+				if (compare(r10, s) >= 0)
+				{
+					break;
+				}
+				r = r10;
+				--k;
+			}
+
+			result.count = 0;
+			result.exponent = k;
+
+			int const wanted = fixed ? k + precision : precision;
+			if (wanted < 0)
+			{
+				// Less than half of the last digit, rounds to zero
+				return;
+			}
+
+			while (result.count < wanted && !r.is_zero())
+			{
+				result.digits[result.count++] = char(r.next_digit(s));
+			}
+
+			if (r.is_zero())
+			{
+				return;
+			}
+
+			// Round half to even, based on the exact remainder
+			r.shift_left(1);
+			int const cmp = compare(r, s);
+			bool const odd = result.count > 0 && result.digits[result.count - 1] % 2;
+			if (cmp > 0 || (cmp == 0 && odd))
+			{
+				result.count = wanted;
+				result.round_up();
+			}
+		}
+
+
+		// Generate the shortest digits that read back to the same value.
+		template<typename ValueT>
+		void generate_shortest_digits(decimal_digits& result, ValueT value)
+		{
+			binary_float const bits = decompose_float(value);
+
+			if (grisu_shortest_digits(result, bits))
+			{
+				result.trim();
+				return;
+			}
+
+			// value == r / s * 10^k, the halfway points to the neighbouring floats
+			// are (r - m_minus) / s and (r + m_plus) / s
+			big_integer r(bits.mantissa);
+			big_integer s(1);
+			big_integer m_plus(1);
+			big_integer m_minus(1);
+
+			int const extra = bits.closer_lower_boundary ? 2 : 1;
+			r.shift_left(extra);
+			s.shift_left(extra);
+			m_plus.shift_left(extra - 1);
+
+			if (bits.exponent >= 0)
+			{
+				r.shift_left(bits.exponent);
+				m_plus.shift_left(bits.exponent);
+				m_minus.shift_left(bits.exponent);
+			}
+			else
+			{
+				s.shift_left(-bits.exponent);
+			}
+
+			int k = estimate_decimal_exponent(value);
+			if (k >= 0)
+			{
+				s.multiply_pow10(k);
+			}
+			else
+			{
+				r.multiply_pow10(-k);
+				m_plus.multiply_pow10(-k);
+				m_minus.multiply_pow10(-k);
+			}
+
+			// With round half to even, the halfway points read back to this value if
+			// the mantissa is even.
+			bool const inclusive = bits.mantissa % 2 == 0;
+
+			auto const reaches_high = [&](big_integer const& rest)
+			{
+				int const cmp = compare_sum(rest, m_plus, s);
+				return inclusive ? cmp >= 0 : cmp > 0;
+			};
+
+			auto const reaches_low = [&](big_integer const& rest)
+			{
+				int const cmp = compare(rest, m_minus);
+				return inclusive ? cmp <= 0 : cmp < 0;
+			};
+
+			// Fix the estimate, so that the upper halfway point is below 10^k
+			while (reaches_high(r))
+			{
+				s.multiply(10);
+				++k;
+			}
+			for (;;)
+			{
+				big_integer r10 = r;
+				big_integer m_plus10 = m_plus;
+				r10.multiply(10);
+				m_plus10.multiply(10);
+				int const cmp = compare_sum(r10, m_plus10, s);
+				if (inclusive ? cmp >= 0 : cmp > 0)
+				{
+					break;
+				}
+				r = r10;
+				m_plus = m_plus10;
+				m_minus.multiply(10);
+				--k;
+			}
+
+			result.count = 0;
+			result.exponent = k;
+
+			for (;;)
+			{
+				int digit = r.next_digit(s);
+				m_plus.multiply(10);
+				m_minus.multiply(10);
+
+				bool const low = reaches_low(r);
+				bool const high = reaches_high(r);
+
+				if (low && high)
+				{
+					// Both digits are in range, take the closer one
+					big_integer r2 = r;
+					r2.shift_left(1);
+					int const cmp = compare(r2, s);
+					digit += cmp > 0 || (cmp == 0 && digit % 2) ? 1 : 0;
+				}
+				else if (high)
+				{
+					++digit;
+				}
+
+				result.digits[result.count++] = char(digit);
+
+				if (low || high)
+				{
+					break;
+				}
+			}
+		}
+
+
+		// Output the digits in fixed notation with the given number of fractional digits.
+		template<typename CharT, typename OutIt>
+		OutIt output_fixed(OutIt out, decimal_digits const& digits, int precision)
+		{
+			for (int place = std::max(digits.exponent, 1) - 1; place >= 0; --place)
+			{
+				*out++ = CharT(digits.at(place));
+			}
+
+			if (precision > 0)
+			{
+				*out++ = CharT('.');
+				for (int place = -1; place >= -precision; --place)
+				{
+					*out++ = CharT(digits.at(place));
+				}
+			}
+
+			return out;
+		}
+
+
+		constexpr int fixed_length(decimal_digits const& digits, int precision)
+		{
+			return std::max(digits.exponent, 1) + (precision > 0 ? precision + 1 : 0);
+		}
+
+
+		// Output the digits in scientific notation with the given number of
+		// fractional digits.
+		template<typename CharT, typename OutIt>
+		OutIt output_scientific(OutIt out, decimal_digits const& digits, int precision)
+		{
+			int const exponent = digits.count ? digits.exponent - 1 : 0;
+
+			*out++ = CharT(digits.at(digits.exponent - 1));
+
+			if (precision > 0)
+			{
+				*out++ = CharT('.');
+				for (int place = 2; place <= precision + 1; ++place)
+				{
+					*out++ = CharT(digits.at(digits.exponent - place));
+				}
+			}
+
+			*out++ = CharT('e');
+			*out++ = CharT(exponent < 0 ? '-' : '+');
+
+			auto const exponent_digits = generate_digits<CharT>(
+					unsigned(exponent < 0 ? -exponent : exponent), conversion_format::decimal);
+			if (exponent_digits.count < 2)
+			{
+				*out++ = CharT('0');
+			}
+			return exponent_digits.output(out);
+		}
+
+
+		constexpr int scientific_length(decimal_digits const& digits, int precision)
+		{
+			int const exponent = digits.count ? digits.exponent - 1 : 0;
+			int const exponent_length = exponent >= 100 || exponent <= -100 ? 3 : 2;
+			return 1 + (precision > 0 ? precision + 1 : 0) + 2 + exponent_length;
+		}
+
+
+		template<typename CharT, typename OutIt, typename ValueT>
+		typename std::enable_if<std::is_floating_point<ValueT>::value, OutIt>::type
+		format_element(OutIt out, conversion_options options, ValueT value)
+		{
+			if constexpr (!std::is_same<ValueT, float>::value && !std::is_same<ValueT, double>::value)
+			{
+				return format_float_sstream<CharT>(out, options, value);
+			}
+			else
+			{
+				options = float_options(options, value);
+
+				auto const sign = sign_from_format(std::signbit(value), options.pos_sign);
+
+				if (!std::isfinite(value))
+				{
+					auto const text = std::isnan(value) ? "nan" : "inf";
+					auto out_func = [&](OutIt out)
+					{
+						return write_chars(out, text, text + 3);
+					};
+					return output_padded_with_sign<CharT>(out, out_func, 3, options, sign);
+				}
+
+				value = std::abs(value);
+
+				decimal_digits digits;
+				int precision = options.precision;
+				bool scientific = options.format == conversion_format::scientific_float;
+
+				if (options.format == conversion_format::shortest_float)
+				{
+					// Shortest representation, in fixed or scientific notation
+					if (value != 0)
+					{
+						generate_shortest_digits(digits, value);
+					}
+
+					int const fixed_precision = std::max(digits.count - digits.exponent, 0);
+					int const scientific_precision = std::max(digits.count - 1, 0);
+					scientific = scientific_length(digits, scientific_precision)
+								 < fixed_length(digits, fixed_precision);
+					precision = scientific ? scientific_precision : fixed_precision;
+
+					// Like printf, fixed notation shows all digits of the integral part
+					if (!scientific && digits.exponent > digits.count)
+					{
+						generate_float_digits(digits, value, 0, true);
+					}
+				}
+				else if (value != 0)
+				{
+					generate_float_digits(digits, value, scientific ? precision + 1 : precision,
+							!scientific);
+				}
+
+				if (scientific)
+				{
+					auto out_func = [&](OutIt out)
+					{
+						return output_scientific<CharT>(out, digits, precision);
+					};
+					return output_padded_with_sign<CharT>(out, out_func,
+							scientific_length(digits, precision), options, sign);
+				}
+				else
+				{
+					auto out_func = [&](OutIt out)
+					{
+						return output_fixed<CharT>(out, digits, precision);
+					};
+					return output_padded_with_sign<CharT>(out, out_func,
+							fixed_length(digits, precision), options, sign);
+				}
+			}
+		}
+
+#elif FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_TO_CHARS
+#ifndef __cpp_lib_to_chars
+#error "std::to_chars for floats is not supported by the standard library."
+#endif
+		// This method uses std::to_chars to convert float values into a buffer on
+		// the stack. It gives the same output as the string stream method, but does
+		// not allocate memory and does not depend on the locale. Values that don't
+		// fit into the buffer (huge values with large precisions) fall back to the
+		// string stream method.
+
+		template<typename CharT, typename OutIt, typename ValueT>
+		typename std::enable_if<std::is_floating_point<ValueT>::value, OutIt>::type
+		format_element(OutIt out, conversion_options options, ValueT value)
+		{
+			std::array<char, 256> buffer;
+
+			auto const result = options.format == conversion_format::shortest_float
+					? std::to_chars(buffer.data(), buffer.data() + buffer.size(), std::abs(value))
+					: std::to_chars(buffer.data(), buffer.data() + buffer.size(),
+							std::abs(value),
+							options.format != conversion_format::scientific_float
+							? std::chars_format::fixed
+							: std::chars_format::scientific,
+							options.precision);
+
+			// The shortest representation always fits into the buffer
+			if (result.ec != std::errc())
+			{
+				return format_float_sstream<CharT, false>(out, options, value);
+			}
+
+			options = float_options(options, value);
+
+			// Widen to the output character type while copying
+			auto out_func = [&](OutIt out)
+			{
+				return write_chars(out, buffer.data(), result.ptr);
+			};
+
+			return output_padded_with_sign<CharT>(out, out_func, int(result.ptr - buffer.data()),
+					options, sign_from_format(std::signbit(value), options.pos_sign));
+		}
+
+#else
+#error "FLOSSY_FLOAT_METHOD undefined."
+#endif
+
+
+		// Convert a single value. Once a truncating output is full, the remaining
+		// values are only measured, which for integers and strings does not
+		// convert them at all.
+		template<typename CharT, typename OutIt, typename ValueT>
+		constexpr OutIt format_value(OutIt out, conversion_options options, ValueT const& value)
+		{
+			if constexpr (is_truncating_iterator<OutIt>)
+			{
+				if (out.full())
+				{
+					return out + format_element<CharT>(counting_iterator(), options, value).count();
+				}
+			}
+
+			return format_element<CharT>(out, options, value);
+		}
+
+
+		// Generic formatting function using iterators
+		//
+		// This function is the main work horse of flossy. It does all the format
+		// string evaluation and formatting of elements.
+		// It recursively calls itself (or the "no values remain" overload above) to
+		// piecewise construct the output string.
+		//
+		// Template parameters:
+		//   OutIt        OutputIterator type used to write the resulting characters
+		//                to. Must accept writes of the same type that dereferencing an
+		//                InputIt (see below) yields.
+		//   InputIt      ForwardIterator used to read the format string characters
+		//                from.
+		//   FirstValueT  Type of the first value to use in conversions.
+		//   ValueTs      Types of the remaining values to be converted.
+		//
+		// Parameters:
+		//   out          Output iterator to store the resulting string characters.
+		//   start        Iterator to beginning of format string.
+		//   end          Iterator to the character one element after the last
+		//                character of the format string.
+		//   first        The first value to be converted.
+		//   elements     Remaining values to be used in later conversions.
+		//
+		// Return value:
+		//   Updated 'out' iterator
+		//
+		// Usage example:
+		//
+		//   std::string result;
+		//   std::string format_str("The first value passed is {}"
+		//                          ", and the second is {}!");
+		//   auto it = format_it(
+		//     std::back_inserter(result), format_str.begin(), format_str.end(),
+		//     42, "foo");
+		//
+		//   'it' can then be used to append further to the string. Instead of string
+		//   and back_inserter, every output iterator works, including
+		//   ostream_iterator, which can be very useful.
+		//
+		template<typename OutIt, typename InputIt, typename FirstValueT, typename... ValueTs>
+		OutIt format_it(OutIt out, InputIt start, InputIt const end, FirstValueT const& first,
+				ValueTs&& ... elements)
+		{
+			// Copy everything from start to the beginning of the first "real" (i.e. not '{{') conversion
+			// specifier to out, transforming {{ into { appropriately.
+			// Read conversion specifier, convert one element and recurse to format the rest.
+
+			while (start != end)
+			{
+				// Copy the literal text up to the next '{' in one go
+				auto const brace = find_brace(start, end);
+				out = write_chars(out, start, brace);
+				start = brace;
+
+				if (start == end)
+				{
+					break;
+				}
+
+				ensure_not_equal(++start, end);
+
+				if (*start != '{')
+				{
+					auto const options = option_reader<InputIt>(start, end).options;
+					out = format_value<typename std::iterator_traits<InputIt>::value_type>(out,
+							options,
+							first);
+					return format_it(out, start, end, std::forward<ValueTs>(elements)...);
+				}
+
+				*out++ = *start++;
+			}
+
+			return out;
+		}
+
+
+		// A piece of a pre-parsed format string. Literal segments are copied to the
+		// output verbatim, placeholder segments convert one value.
+		struct format_segment
+		{
+			// Position of the segment in the format string. For placeholders this is
+			// the position of the opening '{'.
+			std::size_t offset = 0;
+			// Number of characters of the literal text or the conversion specifier.
+			std::size_t length = 0;
+			// True if this segment is a conversion specifier.
+			bool placeholder = false;
+			// Index of the value converted by this placeholder.
+			std::size_t argument = 0;
+			conversion_options options;
+		};
+
+
+		// Split a format string into literal and placeholder segments, calling
+		// on_segment for each one. Unlike format_it, the whole string is validated,
+		// even the parts that would not be reached with the given values.
+		template<typename CharT, typename SegmentFunc>
+		constexpr void parse_format(std::basic_string_view<CharT> format_str, SegmentFunc&& on_segment)
+		{
+			CharT const* const begin = format_str.data();
+			CharT const* const end = begin + format_str.size();
+			CharT const* literal = begin;
+			CharT const* start = begin;
+			std::size_t argument = 0;
+
+			auto const emit_literal = [&](CharT const* literal_end)
+			{
+				if (literal != literal_end)
+				{
+					format_segment segment;
+					segment.offset = std::size_t(literal - begin);
+					segment.length = std::size_t(literal_end - literal);
+					on_segment(segment);
+				}
+			};
+
+			while (start != end)
+			{
+				if (*start != '{')
+				{
+					++start;
+					continue;
+				}
+
+				ensure_not_equal(start + 1, end);
+
+				if (start[1] == '{')
+				{
+					// Keep the first brace of '{{' as literal text, drop the second.
+					emit_literal(start + 1);
+					start += 2;
+					literal = start;
+					continue;
+				}
+
+				emit_literal(start);
+
+				CharT const* spec = start + 1;
+				format_segment segment;
+				segment.offset = std::size_t(start - begin);
+				segment.placeholder = true;
+				segment.argument = argument++;
+				segment.options = option_reader<CharT const*>(spec, end).options;
+				segment.length = std::size_t(spec - start);
+				on_segment(segment);
+
+				start = spec;
+				literal = start;
+			}
+
+			emit_literal(end);
+		}
+
+
+		// Base class of the string types generated by FLOSSY_FMT. Used to tell
+		// compile-time format strings apart from all other arguments.
+		struct compiled_string
+		{
+		};
+
+
+		template<typename T>
+		constexpr bool is_compiled_string = std::is_base_of<compiled_string, std::decay_t<T>>::value;
+
+
+		// Number of segments the given format string is split into.
+		template<typename CharT>
+		constexpr std::size_t count_segments(std::basic_string_view<CharT> format_str)
+		{
+			std::size_t count = 0;
+			parse_format(format_str, [&](format_segment const&)
+			{ ++count; });
+			return count;
+		}
+
+
+		template<std::size_t Count, typename CharT>
+		constexpr std::array<format_segment, Count> make_segments(std::basic_string_view<CharT> format_str)
+		{
+			std::array<format_segment, Count> segments{};
+			std::size_t index = 0;
+			parse_format(format_str, [&](format_segment const& segment)
+			{ segments[index++] = segment; });
+			return segments;
+		}
+
+
+		template<std::size_t Count>
+		constexpr std::size_t count_placeholder_segments(std::array<format_segment, Count> const& segments)
+		{
+			std::size_t count = 0;
+			for (auto const& segment : segments)
+			{
+				count += segment.placeholder ? 1 : 0;
+			}
+			return count;
+		}
+
+
+		// The segment program of a format string known at compile time. All parsing
+		// happens during compilation, an invalid format string is a compile error.
+		template<typename S>
+		struct compiled_format
+		{
+			static constexpr auto text = S::value();
+
+			using char_type = typename decltype(text)::value_type;
+
+			static constexpr std::size_t size = count_segments(text);
+
+			static constexpr std::array<format_segment, size> segments = make_segments<size>(text);
+
+			static constexpr std::size_t placeholders = count_placeholder_segments(segments);
+
+			// Index of the first segment that is not reached with the given number of
+			// values, or size if there are enough values for all placeholders.
+			static constexpr std::size_t first_unused(std::size_t value_count)
+			{
+				if (value_count == 0)
+				{
+					return 0;
+				}
+
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					if (segments[i].placeholder && segments[i].argument + 1 == value_count)
+					{
+						return i + 1;
+					}
+				}
+				return size;
+			}
+
+
+			// Position in the format string the unused segments start at.
+			static constexpr std::size_t unused_offset(std::size_t value_count)
+			{
+				std::size_t const index = first_unused(value_count);
+				return index == 0 ? 0 : segments[index - 1].offset + segments[index - 1].length;
+			}
+		};
+
+
+		// Output a single segment of a compiled format string. Like format_it, the
+		// format string following the last converted value is copied verbatim.
+		template<typename Format, std::size_t Index, typename OutIt, typename Values>
+		constexpr OutIt format_compiled_segment(OutIt out, Values const& values)
+		{
+			using CharT = typename Format::char_type;
+
+			constexpr format_segment segment = Format::segments[Index];
+			constexpr std::size_t unused = Format::first_unused(std::tuple_size<Values>::value);
+
+			if constexpr (Index > unused)
+			{
+				return out;
+			}
+			else if constexpr (Index == unused)
+			{
+				constexpr std::size_t offset = Format::unused_offset(std::tuple_size<Values>::value);
+				return write_chars(out, Format::text.begin() + offset, Format::text.end());
+			}
+			else if constexpr (segment.placeholder)
+			{
+				return format_value<CharT>(out, segment.options, std::get<segment.argument>(values));
+			}
+			else
+			{
+				auto const start = Format::text.begin() + segment.offset;
+				return write_chars(out, start, start + segment.length);
+			}
+		}
+
+
+		template<typename Format, typename OutIt, typename Values, std::size_t... Indices>
+		constexpr OutIt format_compiled(OutIt out, Values const& values, std::index_sequence<Indices...>)
+		{
+			((out = format_compiled_segment<Format, Indices>(out, values)), ...);
+			return out;
+		}
+
+
+		// Formatting function for format strings created with FLOSSY_FMT. Works like
+		// the format_it above, but the format string has already been parsed at
+		// compile time, so only the literal text and the values are output.
+		template<typename OutIt, typename S, typename... ValueTs>
+		constexpr std::enable_if_t<is_compiled_string<S>, OutIt>
+		format_it(OutIt out, S const&, ValueTs&& ... elements)
+		{
+			using Format = compiled_format<std::decay_t<S>>;
+
+			static_assert(Format::placeholders == sizeof...(ValueTs),
+					"The number of placeholders does not match the number of values");
+
+			return format_compiled<Format>(out, std::forward_as_tuple(elements...),
+					std::make_index_sequence<Format::size>());
+		}
+
+
+		// Convert the value selected by the given placeholder segment.
+		template<typename CharT, typename OutIt, typename... ValueTs>
+		OutIt format_argument(OutIt out, format_segment const& segment, ValueTs const& ... values)
+		{
+			std::size_t index = 0;
+			((index++ == segment.argument
+			  ? (void)(out = format_value<CharT>(out, segment.options, values))
+			  : (void)0), ...);
+			return out;
+		}
+
+
+		// Output a format string that was split into segments by parse_format.
+		// Behaves like format_it when running out of values: the format string
+		// following the last converted value is copied verbatim.
+		template<typename CharT, typename OutIt, typename... ValueTs>
+		OutIt format_segments(OutIt out, std::basic_string_view<CharT> format_str,
+				format_segment const* first, format_segment const* last, ValueTs const& ... values)
+		{
+			if constexpr (sizeof...(values) == 0)
+			{
+				return write_chars(out, format_str.begin(), format_str.end());
+			}
+			else
+			{
+				for (; first != last; ++first)
+				{
+					auto const start = format_str.begin() + first->offset;
+
+					if (!first->placeholder)
+					{
+						out = write_chars(out, start, start + first->length);
+					}
+					else
+					{
+						out = format_argument<CharT>(out, *first, values...);
+
+						if (first->argument + 1 == sizeof...(values))
+						{
+							return write_chars(out, start + first->length, format_str.end());
+						}
+					}
+				}
+
+				return out;
+			}
+		}
+
+
+		// Output a format string whose segments were checked by trust_segments
+		// for exactly sizeof...(values) values. Every placeholder has its value
+		// and the text after the last one is a single literal segment, so
+		// nothing is checked while formatting.
+		template<typename CharT, typename OutIt, typename... ValueTs>
+		OutIt format_trusted_segments(OutIt out, std::basic_string_view<CharT> format_str,
+				format_segment const* first, format_segment const* last, ValueTs const& ... values)
+		{
+			for (; first != last; ++first)
+			{
+				if (first->placeholder)
+				{
+					out = format_argument<CharT>(out, *first, values...);
+				}
+				else
+				{
+					auto const start = format_str.begin() + first->offset;
+					out = write_chars(out, start, start + first->length);
+				}
+			}
+
+			return out;
+		}
+
+
+		// Ensure the segments of a format string have exactly value_count
+		// placeholders and prepare them for format_trusted_segments: like
+		// format_it, the text following the last placeholder is copied
+		// verbatim, so it replaces the segments after it.
+		inline void trust_segments(std::vector<format_segment>& segments, std::size_t text_size,
+				std::size_t value_count)
+		{
+			std::size_t placeholders = 0;
+			std::size_t kept = 0;
+			std::size_t tail = 0;
+
+			for (std::size_t i = 0; i < segments.size(); ++i)
+			{
+				if (segments[i].placeholder && ++placeholders == value_count)
+				{
+					kept = i + 1;
+					tail = segments[i].offset + segments[i].length;
+				}
+			}
+
+			if (placeholders != value_count)
+			{
+				raise_error(format_errc::placeholder_count);
+			}
+
+			segments.resize(kept);
+
+			if (tail != text_size)
+			{
+				format_segment segment;
+				segment.offset = tail;
+				segment.length = text_size - tail;
+				segments.push_back(segment);
+			}
+		}
+	}
+
+
+	// Value count of a parsed_format that can be used with any number of values
+	constexpr std::size_t unchecked_values = std::size_t(-1);
+
+
+	/**
+	 * @page Parsed Format Strings.
+	 *
+	 * A format string that is parsed once and can then be used for formatting
+	 * any number of times. Meant for format strings that are only known at
+	 * runtime, e.g. loaded from a configuration file. For format strings known
+	 * at compile time, use FLOSSY_FMT instead.
+	 *
+	 * The whole format string is validated by the constructor, which throws
+	 * std::invalid_argument for invalid format strings. Formatting with a
+	 * parsed format string does not parse anything and does no validation.
+	 *
+	 * If the number of values is given as Values, the constructor also throws
+	 * std::invalid_argument unless the format string has exactly that many
+	 * placeholders, and formatting with any other number of values is a
+	 * compile error. Formatting then runs a loop without any checks, which
+	 * cannot throw by itself. Without Values, format strings behave as
+	 * usual: placeholders without a value are copied verbatim and extra
+	 * values are ignored.
+	 *
+	 * Created from a FLOSSY_FMT string, the format string is validated at
+	 * compile time and a wrong number of placeholders is a compile error.
+	 *
+	 * @example
+	 * @code
+	 * flossy::parsed_format<char> const format_str(config.message_template);
+	 * auto result = format(format_str, 42, "foo");
+	 *
+	 * flossy::parsed_format<char, 2> const checked(config.message_template);
+	 * auto checked_result = format(checked, 42, "foo");
+	 * @endcode
+	 *
+	 * @tparam CharT Character type of the format string.
+	 * @tparam Values Number of values the format string is used with, or
+	 * unchecked_values.
+	 */
+	template<typename CharT, std::size_t Values = unchecked_values>
+	class parsed_format
+	{
+		std::basic_string<CharT> text;
+		std::vector<internal::format_segment> segments;
+
+	public:
+		explicit parsed_format(std::basic_string<CharT> format_str)
+				: text(std::move(format_str))
+		{
+			internal::parse_format(view(), [&](internal::format_segment const& segment)
+			{ segments.push_back(segment); });
+
+			if constexpr (Values != unchecked_values)
+			{
+				internal::trust_segments(segments, text.size(), Values);
+			}
+		}
+
+		explicit parsed_format(CharT const* format_str)
+				: parsed_format(std::basic_string<CharT>(format_str))
+		{
+		}
+
+		// Create from a FLOSSY_FMT string, which was already parsed at compile time.
+		template<typename S, typename = std::enable_if_t<internal::is_compiled_string<S>>>
+		explicit parsed_format(S const&)
+				: text(S::value())
+		{
+			using Format = internal::compiled_format<S>;
+
+			static_assert(std::is_same<typename Format::char_type, CharT>::value,
+					"The character type of the format string does not match");
+			static_assert(Values == unchecked_values || Format::placeholders == Values,
+					"The number of placeholders does not match the number of values");
+
+			segments.assign(Format::segments.begin(), Format::segments.end());
+
+			if constexpr (Values != unchecked_values)
+			{
+				internal::trust_segments(segments, text.size(), Values);
+			}
+		}
+
+		// The format string this object was created from.
+		std::basic_string_view<CharT> view() const noexcept
+		{
+			return text;
+		}
+
+		// Output the format string with the given values to out.
+		template<typename OutIt, typename... ValueTs>
+		OutIt format_to(OutIt out, ValueTs const& ... values) const
+		{
+			if constexpr (Values == unchecked_values)
+			{
+				return internal::format_segments<CharT>(out, view(), segments.data(),
+						segments.data() + segments.size(), values...);
+			}
+			else
+			{
+				static_assert(sizeof...(values) == Values,
+						"The number of values does not match the parsed format string");
+
+				return internal::format_trusted_segments<CharT>(out, view(), segments.data(),
+						segments.data() + segments.size(), values...);
+			}
+		}
+	};
+
+
+	namespace internal
+	{
+		// Formatting function for parsed format strings. Works like the format_it
+		// above, but the format string was already parsed by the constructor of
+		// parsed_format.
+		template<typename OutIt, typename CharT, std::size_t Values, typename... ValueTs>
+		OutIt format_it(OutIt out, parsed_format<CharT, Values> const& format_str, ValueTs&& ... elements)
+		{
+			return format_str.format_to(out, elements...);
+		}
+
+
+		template<typename T>
+		constexpr bool is_parsed_format = false;
+
+		template<typename CharT, std::size_t Values>
+		constexpr bool is_parsed_format<parsed_format<CharT, Values>> = true;
+
+
+		// Format to an output stream. format_func is called with the output
+		// iterator to format to. Like an unformatted output function of the
+		// stream, nothing is written if the stream is not good, and badbit is
+		// set if the stream buffer does not take all characters.
+		template<typename CharT, typename Traits, typename FormatFunc>
+		void format_to_stream(std::basic_ostream<CharT, Traits>& ostream,
+				std::basic_string_view<CharT> format_str, FormatFunc format_func)
+		{
+			typename std::basic_ostream<CharT, Traits>::sentry const sentry(ostream);
+			if (!sentry)
+			{
+				return;
+			}
+
+			stats_scope<CharT> const stats(format_str);
+			stream_writer<CharT, Traits> writer(*ostream.rdbuf());
+
+#ifdef FLOSSY_NO_EXCEPTIONS
+			format_func(stream_iterator<CharT, Traits>(writer));
+#else
+			try
+			{
+				format_func(stream_iterator<CharT, Traits>(writer));
+			}
+			catch (...)
+			{
+				// Keep the output up to the error, like unbuffered output would.
+				writer.flush();
+				throw;
+			}
+#endif
+
+			if (!writer.flush())
+			{
+				ostream.setstate(std::ios_base::badbit);
+			}
+#ifdef FLOSSY_ENABLE_STATS
+			stats.finish([&]
+			{
+				return writer.written();
+			});
+#endif
+		}
+
+
+		// Values whose formatted size can be computed without converting them.
+		template<typename CharT, typename ValueT>
+		constexpr bool is_cheaply_sizable = std::is_integral<std::decay_t<ValueT>>::value
+											|| std::is_convertible<ValueT const&, std::basic_string_view<CharT>>::value;
+
+
+		// Create the string returned by the format functions. format_func is
+		// called with the output iterator to format to. If all values are
+		// cheaply sizable, the size of the result is computed first, so the
+		// string is allocated once and written through a pointer. Otherwise, the
+		// values are converted only once and appended to the string, which
+		// reserves the size of the format string first. The string uses the
+		// given allocator.
+		template<typename CharT, typename... ValueTs, typename FormatFunc,
+				typename Allocator = std::allocator<CharT>>
+		std::basic_string<CharT, std::char_traits<CharT>, Allocator> format_to_string(
+				std::basic_string_view<CharT> format_str, FormatFunc format_func,
+				Allocator const& allocator = Allocator())
+		{
+			stats_scope<CharT> const stats(format_str);
+			std::basic_string<CharT, std::char_traits<CharT>, Allocator> result(allocator);
+
+			if constexpr ((is_cheaply_sizable<CharT, ValueTs> && ...))
+			{
+				result.resize(format_func(counting_iterator()).count());
+				format_func(result.data());
+			}
+			else
+			{
+				result.reserve(format_str.size());
+				format_func(std::back_inserter(result));
+			}
+
+			stats.finish([&]
+			{
+				return result.size();
+			});
+			return result;
+		}
+
+
+		// Append formatted output to a memory buffer. format_func is called with
+		// the output iterator to format to. Like format_to_string, the output is
+		// measured first and written through a pointer if all values are
+		// cheaply sizable. Returns the appended characters.
+		template<typename CharT, std::size_t InlineN, typename... ValueTs, typename FormatFunc>
+		std::basic_string_view<CharT> format_to_buffer(basic_memory_buffer<CharT, InlineN>& buffer,
+				std::basic_string_view<CharT> format_str, FormatFunc format_func)
+		{
+			stats_scope<CharT> const stats(format_str);
+			std::size_t const start = buffer.size();
+
+			if constexpr ((is_cheaply_sizable<CharT, ValueTs> && ...))
+			{
+				buffer.resize(start + format_func(counting_iterator()).count());
+				format_func(buffer.data() + start);
+			}
+			else
+			{
+				format_func(std::back_inserter(buffer));
+			}
+
+			stats.finish([&]
+			{
+				return buffer.size() - start;
+			});
+			return buffer.view().substr(start);
+		}
+
+
+		// Keeps a function parameter out of template argument deduction
+		template<typename T>
+		struct identity
+		{
+			using type = T;
+		};
+
+		template<typename T>
+		using identity_t = typename identity<T>::type;
+	}
+
+
+	/**
+	 * A single value to be formatted by vformat. Integers and strings are
+	 * stored by value, all other types by a pointer to the value and a
+	 * function converting it with format_element. Values of these types must
+	 * outlive the format_arg.
+	 *
+	 * Integers are stored with their size and signedness, so they are
+	 * formatted exactly like by format_it. Integers smaller than int (which
+	 * includes characters) are formatted through a function pointer, for the
+	 * same reason. Floats are too, so the float formatters are only compiled
+	 * into programs that format floats.
+	 *
+	 * @tparam CharT Character type of the format string.
+	 * @tparam OutIt Output iterator type the value is formatted to.
+	 */
+	template<typename CharT, typename OutIt>
+	class format_arg
+	{
+		enum class arg_type
+		{
+			int_value,
+			unsigned_value,
+			long_long_value,
+			unsigned_long_long_value,
+			string_value,
+			custom_value
+		};
+
+		struct string_value
+		{
+			CharT const* data;
+			std::size_t size;
+		};
+
+		struct custom_value
+		{
+			void const* value;
+			OutIt (* format)(OutIt, internal::conversion_options, void const*);
+		};
+
+		arg_type type;
+
+		union
+		{
+			int int_value;
+			unsigned unsigned_value;
+			long long long_long_value;
+			unsigned long long unsigned_long_long_value;
+			string_value string;
+			custom_value custom;
+		};
+
+
+		template<typename ValueT>
+		static OutIt format_custom(OutIt out, internal::conversion_options options, void const* value)
+		{
+			return internal::format_value<CharT>(out, options, *static_cast<ValueT const*>(value));
+		}
+
+	public:
+		template<typename ValueT>
+		explicit format_arg(ValueT const& value)
+		{
+			constexpr bool is_integer = std::is_integral<ValueT>::value && !std::is_same<ValueT, bool>::value;
+
+			if constexpr (is_integer && sizeof(ValueT) == sizeof(int) && std::is_signed<ValueT>::value)
+			{
+				type = arg_type::int_value;
+				int_value = int(value);
+			}
+			else if constexpr (is_integer && sizeof(ValueT) == sizeof(int))
+			{
+				type = arg_type::unsigned_value;
+				unsigned_value = unsigned(value);
+			}
+			else if constexpr (is_integer && sizeof(ValueT) == sizeof(long long)
+							   && std::is_signed<ValueT>::value)
+			{
+				type = arg_type::long_long_value;
+				long_long_value = (long long) value;
+			}
+			else if constexpr (is_integer && sizeof(ValueT) == sizeof(long long))
+			{
+				type = arg_type::unsigned_long_long_value;
+				unsigned_long_long_value = (unsigned long long) value;
+			}
+			else if constexpr (std::is_convertible<ValueT const&, CharT const*>::value
+							   || std::is_same<ValueT, std::basic_string<CharT>>::value
+							   || std::is_same<ValueT, std::basic_string_view<CharT>>::value)
+			{
+				std::basic_string_view<CharT> const view(value);
+				type = arg_type::string_value;
+				string = { view.data(), view.size() };
+			}
+			else
+			{
+				type = arg_type::custom_value;
+				custom = { &value, &format_custom<ValueT> };
+			}
+		}
+
+
+		// Format the value to out with the given options.
+		OutIt format(OutIt out, internal::conversion_options options) const
+		{
+			switch (type)
+			{
+			case arg_type::int_value:
+				return internal::format_value<CharT>(out, options, int_value);
+			case arg_type::unsigned_value:
+				return internal::format_value<CharT>(out, options, unsigned_value);
+			case arg_type::long_long_value:
+				return internal::format_value<CharT>(out, options, long_long_value);
+			case arg_type::unsigned_long_long_value:
+				return internal::format_value<CharT>(out, options, unsigned_long_long_value);
+			case arg_type::string_value:
+				return internal::format_value<CharT>(out, options,
+						std::basic_string_view<CharT>(string.data, string.size));
+			default:
+				return custom.format(out, options, custom.value);
+			}
+		}
+	};
+
+
+	// The values passed to vformat. Refers to the format_arg objects of a
+	// format_arg_store, which must outlive it.
+	template<typename CharT, typename OutIt>
+	class format_args
+	{
+		format_arg<CharT, OutIt> const* args;
+		std::size_t count;
+
+	public:
+		format_args(format_arg<CharT, OutIt> const* args, std::size_t count) noexcept
+				: args(args), count(count)
+		{
+		}
+
+		std::size_t size() const noexcept
+		{
+			return count;
+		}
+
+		format_arg<CharT, OutIt> const& operator[](std::size_t index) const noexcept
+		{
+			return args[index];
+		}
+	};
+
+
+	namespace internal
+	{
+		// The array of a format_arg_store. A base class of it, so it is
+		// initialized before the format_args base referring to it.
+		template<typename CharT, typename OutIt, std::size_t Count>
+		struct format_arg_array
+		{
+			std::array<format_arg<CharT, OutIt>, Count> values;
+		};
+	}
+
+
+	// Holds the format_arg objects for the given number of values. Created by
+	// make_format_args, usually as a temporary passed to vformat.
+	template<typename CharT, typename OutIt, std::size_t Count>
+	class format_arg_store
+			: private internal::format_arg_array<CharT, OutIt, Count>, public format_args<CharT, OutIt>
+	{
+	public:
+		template<typename... ValueTs>
+		explicit format_arg_store(ValueTs const& ... values)
+				: internal::format_arg_array<CharT, OutIt, Count>{{{ format_arg<CharT, OutIt>(values)... }}},
+				  format_args<CharT, OutIt>(this->values.data(), Count)
+		{
+		}
+
+		// The base refers to the own array
+		format_arg_store(format_arg_store const&) = delete;
+		format_arg_store& operator=(format_arg_store const&) = delete;
+	};
+
+
+	// Pack the given values for formatting to output iterators of type OutIt.
+	template<typename CharT, typename OutIt, typename... ValueTs>
+	format_arg_store<CharT, OutIt, sizeof...(ValueTs)> make_format_args(ValueTs const& ... values)
+	{
+		return format_arg_store<CharT, OutIt, sizeof...(ValueTs)>(values...);
+	}
+
+
+	/**
+	 * @page Type-Erased Formatting.
+	 *
+	 * Works like format_it, but takes the values packed by make_format_args.
+	 * The formatting loop is compiled once per character and output iterator
+	 * type, instead of once per combination of value types. The format and
+	 * formatted_size functions for format strings given as strings are
+	 * wrappers around it.
+	 *
+	 * @example
+	 * @code
+	 * std::string result;
+	 * using OutIt = std::back_insert_iterator<std::string>;
+	 * flossy::vformat(std::back_inserter(result), "The first value passed is {}",
+	 * 				flossy::make_format_args<char, OutIt>(42));
+	 * @endcode
+	 *
+	 * @tparam OutIt Output iterator type to write the resulting characters to.
+	 * @tparam CharT Character type of the format string.
+	 *
+	 * @param out Output iterator to store the resulting string characters.
+	 * @param format_str Format string to be used when formatting.
+	 * @param args The values to be formatted.
+	 *
+	 * @return Updated 'out' iterator.
+	 */
+	template<typename OutIt, typename CharT>
+	OutIt vformat(OutIt out, internal::identity_t<std::basic_string_view<CharT>> format_str,
+			format_args<CharT, OutIt> const& args)
+	{
+		auto start = format_str.begin();
+		auto const end = format_str.end();
+
+		// Without values, the format string is copied verbatim, like by format_it.
+		if (args.size() == 0)
+		{
+			return internal::write_chars(out, start, end);
+		}
+
+		std::size_t index = 0;
+
+		while (start != end)
+		{
+			auto const brace = internal::find_brace(start, end);
+			out = internal::write_chars(out, start, brace);
+			start = brace;
+
+			if (start == end)
+			{
+				break;
+			}
+
+			internal::ensure_not_equal(++start, end);
+
+			if (*start != '{')
+			{
+				auto const options = internal::option_reader<decltype(start)>(start, end).options;
+				out = args[index].format(out, options);
+
+				// The rest of the format string is copied verbatim once all values
+				// are converted.
+				if (++index == args.size())
+				{
+					return internal::write_chars(out, start, end);
+				}
+				continue;
+			}
+
+			*out++ = *start++;
+		}
+
+		return out;
+	}
+
+
+	namespace internal
+	{
+		// Format the given values with vformat
+		template<typename CharT, typename OutIt, typename... ValueTs>
+		OutIt vformat_values(OutIt out, std::basic_string_view<CharT> format_str, ValueTs const& ... values)
+		{
+			return vformat(out, format_str, make_format_args<CharT, OutIt>(values...));
+		}
+
+
+		// Character type of a format string of any kind: C strings, strings,
+		// string views, compiled and parsed format strings.
+		template<typename FormatT, typename = void>
+		struct format_char
+		{
+			using type = std::remove_cv_t<std::remove_pointer_t<std::decay_t<FormatT>>>;
+		};
+
+		template<typename CharT, typename Traits, typename Allocator>
+		struct format_char<std::basic_string<CharT, Traits, Allocator>>
+		{
+			using type = CharT;
+		};
+
+		template<typename CharT, typename Traits>
+		struct format_char<std::basic_string_view<CharT, Traits>>
+		{
+			using type = CharT;
+		};
+
+		template<typename CharT, std::size_t Values>
+		struct format_char<parsed_format<CharT, Values>>
+		{
+			using type = CharT;
+		};
+
+		template<typename S>
+		struct format_char<S, std::enable_if_t<is_compiled_string<S>>>
+		{
+			using type = typename compiled_format<S>::char_type;
+		};
+
+		template<typename FormatT>
+		using format_char_t = typename format_char<FormatT>::type;
+
+
+		// Format with a format string of any kind. Compiled and parsed format
+		// strings use their own format_it, all others vformat.
+		template<typename OutIt, typename FormatT, typename... ValueTs>
+		OutIt format_any(OutIt out, FormatT const& format_str, ValueTs const& ... values)
+		{
+			if constexpr (is_compiled_string<FormatT> || is_parsed_format<FormatT>)
+			{
+				return format_it(out, format_str, values...);
+			}
+			else
+			{
+				return vformat_values(out, std::basic_string_view<format_char_t<FormatT>>(format_str),
+						values...);
+			}
+		}
+
+
+		// The text of a format string of any kind.
+		template<typename FormatT>
+		std::basic_string_view<format_char_t<FormatT>> format_view(FormatT const& format_str)
+		{
+			if constexpr (is_compiled_string<FormatT>)
+			{
+				return FormatT::value();
+			}
+			else if constexpr (is_parsed_format<FormatT>)
+			{
+				return format_str.view();
+			}
+			else
+			{
+				return std::basic_string_view<format_char_t<FormatT>>(format_str);
+			}
+		}
+	}
+
+
+	/**
+	 * @page Basic Format String.
+	 *
+	 * Convenience function wrapper for format_it that allows formatting a
+	 * format string and values directly into a string and returning that.
+	 *
+	 * @example
+	 * @code
+	 * auto result = format("The first value passed is {}, and the second is {}!"s,
+	 * 						42, "foo");
+	 * @endcode
+	 *
+	 * @tparam CharT Character type to generate in the output string.
+	 * @tparam ValueTs Types of the values to be formatted.
+	 *
+	 * @param format_str Format string to be used when formatting the string.
+	 * 	It will be passed to format_it directly.
+	 * @param elements The elements to be formatted. They are passed to
+	 * format_it verbatim.
+	 *
+	 * @return The formatted string.
+	 */
+	template<typename CharT, typename... ValueTs>
+	std::basic_string<CharT>
+	format(std::basic_string_view<CharT> format_str, ValueTs&& ... elements)
+	{
+		// With this if-constexpr, We ensure that the code block will never be
+		// called with an empty argument list.
+		if constexpr (sizeof...(elements) > 0)
+		{
+			return internal::format_to_string<CharT, ValueTs...>(format_str, [&](auto out)
+			{
+				return internal::vformat_values(out, format_str, elements...);
+			});
+		}
+		else
+		{
+			// Convert the std::basic_string_view to std::base_string
+			return { format_str.begin(), format_str.end() };
+		}
+	}
+
+	/**
+	 * @page Implicit Conversion in Template Deduction Process.
+	 *
+	 * The documentation of this method is the same that of: Basic Format
+	 * String page.
+	 *
+	 * Current the standard now allow the implicit conversion in the template
+	 * deduction process. Is needed added a overload for manage the
+	 * std::basic_string<Char> (aka. std::string, std::u32string, etc ...).
+	 *
+	 * Implicit conversion is not a part of the template deduction process.
+	 * References: https://stackoverflow.com/a/22848951
+	 */
+	template<typename CharT, typename ... ValueTs>
+	std::basic_string<CharT>
+	format(const std::basic_string<CharT>& format_str, ValueTs&& ... elements)
+	{
+		// With this if-constexpr, We ensure that the code block will never be
+		// called with an empty argument list.
+		if constexpr (sizeof...(elements) > 0)
+		{
+			return format(std::basic_string_view<CharT>(format_str), elements...);
+		}
+		else
+		{
+			// Return the string without modifications.
+			return format_str;
+		}
+	}
+
+
+	/**
+	 * The documentation of this method is the same that of: Basic Format
+	 * String page.
+	 *
+	 * This method is overload for manage const char*. See the why is needed in
+	 * the Implicit Conversion in Template Deduction Process page.
+	 */
+	template<typename CharT, typename... ValueTs>
+	std::basic_string<CharT> format(CharT const* format_str, ValueTs&& ... elements)
+	{
+		return format(std::basic_string_view<CharT>(format_str),
+				std::forward<ValueTs>(elements)...);
+	}
+
+
+	// Convenience function wrapper for format_it that allows formatting a format
+	// string and values directly to an ostream.
+	//
+	// Template parameters:
+	//   CharT       Character type to generate in the output string.
+	//   Traits      Character traits to be used on the stream.
+	//   ValueTs     Types of the values to be formatted.
+	//
+	// Parameters:
+	//   ostream     Stream to write the resulting string to.
+	//   format_str  Format string to be used when formatting the string. It will
+	//               be passed to format_it directly.
+	//   elements    The elements to be formatted. They are passed to format_it
+	//               verbatim.
+	//
+	// Return value:
+	//   The ostream that was passed in.
+	//
+	// Usage example:
+	//
+	//   format(std::cout, "The first value passed is {}, and the second is {}!"s,
+	//          42, "foo");
+	//
+	template<typename CharT, typename Traits, typename... ValueTs>
+	std::basic_ostream<CharT, Traits>& format(
+			std::basic_ostream<CharT, Traits>& ostream, std::basic_string_view<CharT> format_str,
+			ValueTs&& ... elements)
+	{
+		// With this if-constexpr, We ensure that the code block will never be
+		// called with an empty argument list.
+		if constexpr (sizeof ... (elements) > 0)
+		{
+			internal::format_to_stream(ostream, format_str, [&](auto out)
+			{
+				return internal::vformat_values(out, format_str, elements...);
+			});
+			return ostream;
+		}
+		else
+		{
+			return (ostream << format_str);
+		}
+	}
+
+
+	// Convenience function wrapper for format_it that allows formatting a format
+	// string and values directly to an ostream. (C string variant)
+	//
+	// Template parameters:
+	//   CharT       Character type to generate in the output string.
+	//   Traits      Character traits to be used on the stream.
+	//   ValueTs     Types of the values to be formatted.
+	//
+	// Parameters:
+	//   ostream     Stream to write the resulting string to.
+	//   format_str  Format string to be used when formatting the string. It will
+	//               be passed to format_it directly.
+	//   elements    The elements to be formatted. They are passed to format_it
+	//               verbatim.
+	//
+	// Return value:
+	//   The ostream that was passed in.
+	//
+	// Usage example:
+	//
+	//   format(std::cout, "The first value passed is {}, and the second is {}!"s,
+	//          42, "foo");
+	//
+	template<typename CharT, typename Traits, typename... ValueTs>
+	std::basic_ostream<CharT, Traits>& format(
+			std::basic_ostream<CharT, Traits>& ostream, CharT const* format_str,
+			ValueTs&& ... elements)
+	{
+		format(ostream, std::basic_string_view<CharT>(format_str),
+				std::forward<ValueTs>(elements)...);
+		return ostream;
+	}
+
+
+	// Convenience function wrapper for format_it that allows formatting a format
+	// string and values directly to an ostream. (std::basic_string variant, see
+	// the Implicit Conversion in Template Deduction Process page)
+	template<typename CharT, typename Traits, typename... ValueTs>
+	std::basic_ostream<CharT, Traits>& format(
+			std::basic_ostream<CharT, Traits>& ostream, std::basic_string<CharT> const& format_str,
+			ValueTs&& ... elements)
+	{
+		format(ostream, std::basic_string_view<CharT>(format_str),
+				std::forward<ValueTs>(elements)...);
+		return ostream;
+	}
+
+
+	/**
+	 * @page Compiled Format Strings.
+	 *
+	 * The documentation of this method is the same that of: Basic Format
+	 * String page.
+	 *
+	 * This overload takes a format string created with FLOSSY_FMT. The string
+	 * is parsed at compile time, so an invalid format string is a compile
+	 * error and formatting only outputs the literal text and the values.
+	 *
+	 * @example
+	 * @code
+	 * auto result = format(FLOSSY_FMT("The first value passed is {}, and the second is {}!"),
+	 * 						42, "foo");
+	 * @endcode
+	 */
+	template<typename S, typename... ValueTs,
+			typename = std::enable_if_t<internal::is_compiled_string<S>>>
+	auto format(S const& format_str, ValueTs&& ... elements)
+	{
+		using CharT = typename internal::compiled_format<S>::char_type;
+
+		return internal::format_to_string<CharT, ValueTs...>(S::value(), [&](auto out)
+		{
+			return internal::format_it(out, format_str, elements...);
+		});
+	}
+
+
+	// Convenience function wrapper for format_it that allows formatting a format
+	// string and values directly to an ostream. (FLOSSY_FMT variant)
+	//
+	// Usage example:
+	//
+	//   format(std::cout, FLOSSY_FMT("The first value passed is {}, and the second is {}!"),
+	//          42, "foo");
+	//
+	template<typename CharT, typename Traits, typename S, typename... ValueTs,
+			typename = std::enable_if_t<internal::is_compiled_string<S>>>
+	std::basic_ostream<CharT, Traits>& format(
+			std::basic_ostream<CharT, Traits>& ostream, S const& format_str,
+			ValueTs&& ... elements)
+	{
+		internal::format_to_stream(ostream, internal::format_view(format_str), [&](auto out)
+		{
+			return internal::format_it(out, format_str, elements...);
+		});
+		return ostream;
+	}
+
+
+	/**
+	 * The documentation of this method is the same that of: Basic Format
+	 * String page.
+	 *
+	 * This overload takes a format string that was parsed in advance, see the
+	 * Parsed Format Strings page.
+	 */
+	template<typename CharT, std::size_t Values, typename... ValueTs>
+	std::basic_string<CharT>
+	format(parsed_format<CharT, Values> const& format_str, ValueTs&& ... elements)
+	{
+		return internal::format_to_string<CharT, ValueTs...>(format_str.view(), [&](auto out)
+		{
+			return format_str.format_to(out, elements...);
+		});
+	}
+
+
+	/**
+	 * @page Allocator-Aware Formatting.
+	 *
+	 * The documentation of this method is the same that of: Basic Format
+	 * String page.
+	 *
+	 * This overload creates the resulting string with the given allocator,
+	 * which is rebound to the character type. It takes format strings of all
+	 * kinds. Like std::allocator_arg in the standard library, the tag tells
+	 * the allocator apart from the format string.
+	 *
+	 * @example
+	 * @code
+	 * auto result = format(std::allocator_arg, arena_allocator,
+	 * 						"The first value passed is {}, and the second is {}!", 42, "foo");
+	 * @endcode
+	 *
+	 * @tparam Allocator Allocator type of the resulting string.
+	 * @tparam FormatT Type of the format string.
+	 * @tparam ValueTs Types of the values to be formatted.
+	 *
+	 * @param allocator Allocator used for the resulting string.
+	 * @param format_str Format string to be used when formatting the string.
+	 * @param elements The elements to be formatted.
+	 *
+	 * @return The formatted string.
+	 */
+	template<typename Allocator, typename FormatT, typename... ValueTs>
+	auto format(std::allocator_arg_t, Allocator const& allocator, FormatT const& format_str,
+			ValueTs&& ... elements)
+	{
+		using CharT = internal::format_char_t<FormatT>;
+		using CharAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<CharT>;
+
+		return internal::format_to_string<CharT, ValueTs...>(internal::format_view(format_str),
+				[&](auto out)
+				{
+					return internal::format_any(out, format_str, elements...);
+				}, CharAllocator(allocator));
+	}
+
+
+#ifdef __cpp_lib_memory_resource
+	/**
+	 * The documentation of this method is the same that of: Basic Format
+	 * String page.
+	 *
+	 * This overload creates a std::pmr string using the given memory
+	 * resource (any class derived from std::pmr::memory_resource), e.g. a
+	 * std::pmr::monotonic_buffer_resource of a request. It takes format
+	 * strings of all kinds.
+	 *
+	 * @example
+	 * @code
+	 * std::pmr::monotonic_buffer_resource arena;
+	 * std::pmr::string result = format(&arena, "The first value passed is {}", 42);
+	 * @endcode
+	 */
+	template<typename ResourceT, typename FormatT, typename... ValueTs,
+			typename = std::enable_if_t<std::is_base_of<std::pmr::memory_resource, ResourceT>::value>>
+	std::pmr::basic_string<internal::format_char_t<std::decay_t<FormatT>>> format(
+			ResourceT* resource, FormatT&& format_str, ValueTs&& ... elements)
+	{
+		using CharT = internal::format_char_t<std::decay_t<FormatT>>;
+
+		return format(std::allocator_arg, std::pmr::polymorphic_allocator<CharT>(resource), format_str,
+				std::forward<ValueTs>(elements)...);
+	}
+#endif
+
+
+	/**
+	 * @page Formatted Size.
+	 *
+	 * Compute the number of characters the format functions produce for the
+	 * given format string and values, without producing them. Integers,
+	 * characters and strings are measured without being converted; other
+	 * values are converted, but not stored.
+	 *
+	 * @example
+	 * @code
+	 * std::string const format_str("{} and {}");
+	 * std::vector<char> buffer(formatted_size(format_str, 42, "foo"));
+	 * internal::format_it(buffer.data(), format_str.begin(), format_str.end(), 42, "foo");
+	 * @endcode
+	 *
+	 * @tparam CharT Character type of the format string.
+	 * @tparam ValueTs Types of the values to be formatted.
+	 *
+	 * @param format_str Format string to be used when formatting.
+	 * @param elements The elements to be formatted.
+	 *
+	 * @return Number of characters of the formatted output.
+	 */
+	template<typename CharT, typename... ValueTs>
+	std::size_t formatted_size(std::basic_string_view<CharT> format_str, ValueTs const& ... elements)
+	{
+		return internal::vformat_values(internal::counting_iterator(), format_str, elements...).count();
+	}
+
+
+	// Overload of formatted_size for std::basic_string format strings.
+	template<typename CharT, typename... ValueTs>
+	std::size_t formatted_size(std::basic_string<CharT> const& format_str,
+			ValueTs const& ... elements)
+	{
+		return formatted_size(std::basic_string_view<CharT>(format_str), elements...);
+	}
+
+
+	// Overload of formatted_size for C string format strings.
+	template<typename CharT, typename... ValueTs>
+	std::size_t formatted_size(CharT const* format_str, ValueTs const& ... elements)
+	{
+		return formatted_size(std::basic_string_view<CharT>(format_str), elements...);
+	}
+
+
+	// Overload of formatted_size for compiled (FLOSSY_FMT) and parsed format
+	// strings.
+	template<typename S, typename... ValueTs,
+			typename = std::enable_if_t<internal::is_compiled_string<S>
+										|| internal::is_parsed_format<S>>>
+	std::size_t formatted_size(S const& format_str, ValueTs const& ... elements)
+	{
+		return internal::format_it(internal::counting_iterator(), format_str, elements...).count();
+	}
+
+
+	// Result of format_to_n
+	struct format_to_n_result
+	{
+		// Number of characters written to the buffer
+		std::size_t written = 0;
+		// Number of characters of the complete output. Larger than written if the
+		// output was truncated.
+		std::size_t size = 0;
+	};
+
+
+	namespace internal
+	{
+		template<typename CharT>
+		format_to_n_result make_format_to_n_result(truncating_iterator<CharT> const& out,
+				std::size_t buffer_size)
+		{
+			return { std::min(out.count(), buffer_size), out.count() };
+		}
+	}
+
+
+	/**
+	 * @page Format To Buffer.
+	 *
+	 * Format into a buffer of fixed size, writing at most buffer_size
+	 * characters. Output that does not fit is dropped. No terminating null
+	 * character is written.
+	 *
+	 * Once the buffer is full, the remaining values are only measured to
+	 * compute the size of the complete output. Integers, characters and
+	 * strings are measured without converting them, and formatting them does
+	 * not allocate memory.
+	 *
+	 * @example
+	 * @code
+	 * char buffer[64];
+	 * auto const result = format_to_n(buffer, sizeof(buffer), "The first value passed is {}", 42);
+	 * std::string_view const text(buffer, result.written);
+	 * @endcode
+	 *
+	 * @tparam CharT Character type of the buffer and format string.
+	 * @tparam ValueTs Types of the values to be formatted.
+	 *
+	 * @param buffer Buffer to write the characters to.
+	 * @param buffer_size Number of characters that fit into buffer.
+	 * @param format_str Format string to be used when formatting.
+	 * @param elements The elements to be formatted.
+	 *
+	 * @return Number of characters written and the size of the complete output.
+	 */
+	template<typename CharT, typename... ValueTs>
+	format_to_n_result format_to_n(CharT* buffer, std::size_t buffer_size,
+			std::basic_string_view<CharT> format_str, ValueTs const& ... elements)
+	{
+		internal::stats_scope<CharT> const stats(format_str);
+		auto const out = internal::vformat_values(internal::truncating_iterator<CharT>(buffer, buffer_size),
+				format_str, elements...);
+		auto const result = internal::make_format_to_n_result(out, buffer_size);
+		stats.finish([&]
+		{
+			return result.written;
+		});
+		return result;
+	}
+
+
+	// Overload of format_to_n for std::basic_string format strings.
+	template<typename CharT, typename... ValueTs>
+	format_to_n_result format_to_n(CharT* buffer, std::size_t buffer_size,
+			std::basic_string<CharT> const& format_str, ValueTs const& ... elements)
+	{
+		return format_to_n(buffer, buffer_size, std::basic_string_view<CharT>(format_str),
+				elements...);
+	}
+
+
+	// Overload of format_to_n for C string format strings.
+	template<typename CharT, typename... ValueTs>
+	format_to_n_result format_to_n(CharT* buffer, std::size_t buffer_size,
+			CharT const* format_str, ValueTs const& ... elements)
+	{
+		return format_to_n(buffer, buffer_size, std::basic_string_view<CharT>(format_str),
+				elements...);
+	}
+
+
+	// Overload of format_to_n for compiled (FLOSSY_FMT) and parsed format
+	// strings.
+	template<typename CharT, typename S, typename... ValueTs,
+			typename = std::enable_if_t<internal::is_compiled_string<S>
+										|| internal::is_parsed_format<S>>>
+	format_to_n_result format_to_n(CharT* buffer, std::size_t buffer_size,
+			S const& format_str, ValueTs const& ... elements)
+	{
+		internal::stats_scope<CharT> const stats(internal::format_view(format_str));
+		auto const out = internal::format_it(internal::truncating_iterator<CharT>(buffer, buffer_size),
+				format_str, elements...);
+		auto const result = internal::make_format_to_n_result(out, buffer_size);
+		stats.finish([&]
+		{
+			return result.written;
+		});
+		return result;
+	}
+
+
+	/**
+	 * @page Format To Memory Buffer.
+	 *
+	 * Append the formatted output to a memory buffer. Does not allocate memory
+	 * as long as the buffer content fits into its capacity. The buffer is not
+	 * cleared first.
+	 *
+	 * @example
+	 * @code
+	 * flossy::memory_buffer buffer;
+	 * flossy::format_to(buffer, "The first value passed is {}", 42);
+	 * @endcode
+	 *
+	 * @tparam CharT Character type of the buffer and format string.
+	 * @tparam InlineN Inline capacity of the buffer.
+	 * @tparam ValueTs Types of the values to be formatted.
+	 *
+	 * @param buffer Buffer to append the characters to.
+	 * @param format_str Format string to be used when formatting.
+	 * @param elements The elements to be formatted.
+	 *
+	 * @return The appended characters.
+	 */
+	template<typename CharT, std::size_t InlineN, typename... ValueTs>
+	std::basic_string_view<CharT> format_to(basic_memory_buffer<CharT, InlineN>& buffer,
+			std::basic_string_view<CharT> format_str, ValueTs const& ... elements)
+	{
+		return internal::format_to_buffer<CharT, InlineN, ValueTs...>(buffer, format_str, [&](auto out)
+		{
+			return internal::vformat_values(out, format_str, elements...);
+		});
+	}
+
+
+	// Overload of format_to for std::basic_string format strings.
+	template<typename CharT, std::size_t InlineN, typename... ValueTs>
+	std::basic_string_view<CharT> format_to(basic_memory_buffer<CharT, InlineN>& buffer,
+			std::basic_string<CharT> const& format_str, ValueTs const& ... elements)
+	{
+		return format_to(buffer, std::basic_string_view<CharT>(format_str), elements...);
+	}
 
-			// Format as char string, convert to wider character types later (in std::copy).
-			// This works with char32_t, while using a basic_ostringstream<char32_t> doesn't.
-			// I did not investigate further, why it doesn't work. :)
-			std::stringstream buffer;
-			buffer.precision(options.precision);
-			buffer.flags(
-					options.format != conversion_format::scientific_float
-					? std::ios::fixed
-					: std::ios::scientific
-			);
-			buffer << std::abs(value);
 
-			auto out_func = [&]()
-			{
-				return std::copy(std::istreambuf_iterator<char>(buffer.rdbuf()),
-						std::istreambuf_iterator<char>(), out);
-			};
+	// Overload of format_to for C string format strings.
+	template<typename CharT, std::size_t InlineN, typename... ValueTs>
+	std::basic_string_view<CharT> format_to(basic_memory_buffer<CharT, InlineN>& buffer,
+			CharT const* format_str, ValueTs const& ... elements)
+	{
+		return format_to(buffer, std::basic_string_view<CharT>(format_str), elements...);
+	}
 
-			// The method std::signbit determines if the given floating point number arg is negative.
-			// Return value: true if arg is negative, false otherwise.
-			bool const isNegative = std::signbit(value);
 
-			return output_padded_with_sign<CharT>(out, out_func, buffer.tellp(), options,
-					sign_from_format(isNegative, options.pos_sign));
-		}
+	// Overload of format_to for compiled (FLOSSY_FMT) and parsed format
+	// strings.
+	template<typename CharT, std::size_t InlineN, typename S, typename... ValueTs,
+			typename = std::enable_if_t<internal::is_compiled_string<S>
+										|| internal::is_parsed_format<S>>>
+	std::basic_string_view<CharT> format_to(basic_memory_buffer<CharT, InlineN>& buffer,
+			S const& format_str, ValueTs const& ... elements)
+	{
+		return internal::format_to_buffer<CharT, InlineN, ValueTs...>(buffer,
+				internal::format_view(format_str), [&](auto out)
+				{
+					return internal::format_it(out, format_str, elements...);
+				});
+	}
 
-#elif FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_FAST
-#error "Fast (and imprecise) float conversion not implemented, yet."
-#elif FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_GRISU
-#error "Grisu float conversion not implemented, yet."
-#else
-#error "FLOSSY_FLOAT_METHOD undefined."
-#endif
 
+	// Convenience function wrapper for format_it that allows formatting a format
+	// string and values directly to an ostream. (parsed_format variant)
+	template<typename CharT, typename Traits, std::size_t Values, typename... ValueTs>
+	std::basic_ostream<CharT, Traits>& format(
+			std::basic_ostream<CharT, Traits>& ostream, parsed_format<CharT, Values> const& format_str,
+			ValueTs&& ... elements)
+	{
+		internal::format_to_stream(ostream, format_str.view(), [&](auto out)
+		{
+			return format_str.format_to(out, elements...);
+		});
+		return ostream;
+	}
 
-		// Generic formatting function using iterators
-		//
-		// This function is the main work horse of flossy. It does all the format
-		// string evaluation and formatting of elements.
-		// It recursively calls itself (or the "no values remain" overload above) to
-		// piecewise construct the output string.
-		//
-		// Template parameters:
-		//   OutIt        OutputIterator type used to write the resulting characters
-		//                to. Must accept writes of the same type that dereferencing an
-		//                InputIt (see below) yields.
-		//   InputIt      ForwardIterator used to read the format string characters
-		//                from.
-		//   FirstValueT  Type of the first value to use in conversions.
-		//   ValueTs      Types of the remaining values to be converted.
-		//
-		// Parameters:
-		//   out          Output iterator to store the resulting string characters.
-		//   start        Iterator to beginning of format string.
-		//   end          Iterator to the character one element after the last
-		//                character of the format string.
-		//   first        The first value to be converted.
-		//   elements     Remaining values to be used in later conversions.
-		//
-		// Return value:
-		//   Updated 'out' iterator
-		//
-		// Usage example:
-		//
-		//   std::string result;
-		//   std::string format_str("The first value passed is {}"
-		//                          ", and the second is {}!");
-		//   auto it = format_it(
-		//     std::back_inserter(result), format_str.begin(), format_str.end(),
-		//     42, "foo");
-		//
-		//   'it' can then be used to append further to the string. Instead of string
-		//   and back_inserter, every output iterator works, including
-		//   ostream_iterator, which can be very useful.
-		//
-		template<typename OutIt, typename InputIt, typename FirstValueT, typename... ValueTs>
-		OutIt format_it(OutIt out, InputIt start, InputIt const end, FirstValueT const& first,
-				ValueTs&& ... elements)
+
+	namespace internal
+	{
+		// Check the conversion specifiers of a format string that format_it
+		// reads with the given number of values, without raising errors. Like
+		// format_it, the text following the last converted value is not checked.
+		template<typename CharT>
+		format_status check_format(std::basic_string_view<CharT> format_str, std::size_t value_count) noexcept
 		{
-			// Copy everything from start to the beginning of the first "real" (i.e. not '{{') conversion
-			// specifier to out, transforming {{ into { appropriately.
-			// Read conversion specifier, convert one element and recurse to format the rest.
+			CharT const* const begin = format_str.data();
+			CharT const* const end = begin + format_str.size();
+			CharT const* start = begin;
 
-			for (; start != end; ++start)
+			for (std::size_t converted = 0; converted < value_count; ++converted)
 			{
-				auto c = *start;
+				start = find_brace(start, end);
 
-				if (c == '{')
+				while (start != end && start + 1 != end && start[1] == '{')
 				{
-					ensure_not_equal(++start, end);
+					start = find_brace(start + 2, end);
+				}
 
-					if (*start != '{')
-					{
-						auto const options = option_reader<InputIt>(start, end).options;
-						format_element<typename std::iterator_traits<InputIt>::value_type>(out,
-								options,
-								first);
-						return format_it(out, start, end, std::forward<ValueTs>(elements)...);
-					}
+				if (start == end)
+				{
+					break;
+				}
+
+				CharT const* spec = start + 1;
+				option_reader<CharT const*> const reader(spec, end, std::nothrow);
 
-					c = '{';
+				switch (reader.status())
+				{
+				case format_errc::none:
+					break;
+				case format_errc::unterminated_placeholder:
+					return format_status{ format_errc::unterminated_placeholder, std::size_t(start - begin) };
+				default:
+					return format_status{ reader.status(), std::size_t(spec - begin) };
 				}
 
-				*out++ = c;
+				start = spec;
 			}
 
-			return out;
+			return format_status();
 		}
 	}
 
+
 	/**
-	 * @page Basic Format String.
+	 * @page Checking Format Strings.
 	 *
-	 * Convenience function wrapper for format_it that allows formatting a
-	 * format string and values directly into a string and returning that.
+	 * Check the whole format string without formatting anything and without
+	 * throwing. Returns the kind and position of the first error. Meant for
+	 * format strings only known at runtime, especially when exceptions are
+	 * disabled and invalid format strings would abort.
 	 *
 	 * @example
 	 * @code
-	 * auto result = format("The first value passed is {}, and the second is {}!"s,
-	 * 						42, "foo");
+	 * if (flossy::check_format(config.message_template))
+	 * {
+	 *   flossy::parsed_format<char> const format_str(config.message_template);
+	 * }
 	 * @endcode
 	 *
-	 * @tparam CharT Character type to generate in the output string.
-	 * @tparam ValueTs Types of the values to be formatted.
+	 * @tparam CharT Character type of the format string.
 	 *
-	 * @param format_str Format string to be used when formatting the string.
-	 * 	It will be passed to format_it directly.
-	 * @param elements The elements to be formatted. They are passed to
-	 * format_it verbatim.
+	 * @param format_str Format string to be checked.
 	 *
-	 * @return The formatted string.
+	 * @return The error found, converts to true if there is none.
 	 */
-	template<typename CharT, typename... ValueTs>
-	std::basic_string<CharT>
-	format(std::basic_string_view<CharT> format_str, ValueTs&& ... elements)
+	template<typename CharT>
+	format_status check_format(std::basic_string_view<CharT> format_str) noexcept
 	{
-		// With this if-constexpr, We ensure that the code block will never be
-		// called with an empty argument list.
-		if constexpr (sizeof...(elements) > 0)
-		{
-			std::basic_string<CharT> result;
-			internal::format_it(std::back_inserter(result), format_str.begin(),
-					format_str.end(), std::forward<ValueTs>(elements)...);
-			return result;
-		}
-		else
-		{
-			// Convert the std::basic_string_view to std::base_string
-			return { format_str.begin(), format_str.end() };
-		}
+		return internal::check_format(format_str, std::size_t(-1));
+	}
+
+
+	// Overload of check_format for std::basic_string format strings.
+	template<typename CharT>
+	format_status check_format(std::basic_string<CharT> const& format_str) noexcept
+	{
+		return check_format(std::basic_string_view<CharT>(format_str));
+	}
+
+
+	// Overload of check_format for C string format strings.
+	template<typename CharT>
+	format_status check_format(CharT const* format_str) noexcept
+	{
+		return check_format(std::basic_string_view<CharT>(format_str));
 	}
 
+
+	// Result of try_format_to
+	template<typename OutIt>
+	struct try_format_result
+	{
+		// Updated output iterator. Nothing was written if there is an error.
+		OutIt out;
+		format_status status;
+	};
+
+
 	/**
-	 * @page Implicit Conversion in Template Deduction Process.
+	 * @page Formatting Without Exceptions.
 	 *
-	 * The documentation of this method is the same that of: Basic Format
-	 * String page.
+	 * Like format_to, but reports invalid format strings by the returned
+	 * status instead of throwing. The format string is checked before
+	 * anything is written, as far as format_to would read it: without
+	 * values, or after the last value, the text is copied verbatim. Compiled
+	 * and parsed format strings were checked when they were created, so
+	 * they always succeed.
 	 *
-	 * Current the standard now allow the implicit conversion in the template
-	 * deduction process. Is needed added a overload for manage the
-	 * std::basic_string<Char> (aka. std::string, std::u32string, etc ...).
+	 * Formatting itself raises no errors then, so with exceptions disabled
+	 * (-fno-exceptions or FLOSSY_NO_EXCEPTIONS) this does not throw or abort.
 	 *
-	 * Implicit conversion is not a part of the template deduction process.
-	 * References: https://stackoverflow.com/a/22848951
+	 * @example
+	 * @code
+	 * std::string result;
+	 * auto const formatted = flossy::try_format_to(std::back_inserter(result), format_str, 42);
+	 * if (!formatted.status)
+	 * {
+	 *   log_error(formatted.status.message(), formatted.status.offset);
+	 * }
+	 * @endcode
+	 *
+	 * @tparam OutIt Output iterator type.
+	 * @tparam FormatT Type of the format string.
+	 * @tparam ValueTs Types of the values to be formatted.
+	 *
+	 * @param out Output iterator to store the resulting string characters.
+	 * @param format_str Format string to be used when formatting.
+	 * @param elements The elements to be formatted.
+	 *
+	 * @return The updated output iterator and the error found.
 	 */
-	template<typename CharT, typename ... ValueTs>
-	std::basic_string<CharT>
-	format(const std::basic_string<CharT>& format_str, ValueTs&& ... elements)
+	template<typename OutIt, typename FormatT, typename... ValueTs>
+	try_format_result<OutIt> try_format_to(OutIt out, FormatT const& format_str, ValueTs const& ... elements)
 	{
-		// With this if-constexpr, We ensure that the code block will never be
-		// called with an empty argument list.
-		if constexpr (sizeof...(elements) > 0)
+		if constexpr (!internal::is_compiled_string<FormatT> && !internal::is_parsed_format<FormatT>)
 		{
-			std::basic_string<CharT> result;
-			internal::format_it(std::back_inserter(result), format_str.begin(), format_str.end(),
-					std::forward<ValueTs>(elements)...);
-			return result;
+			auto const status = internal::check_format(internal::format_view(format_str), sizeof...(elements));
+			if (!status)
+			{
+				return { out, status };
+			}
 		}
-		else
+
+		return { internal::format_any(out, format_str, elements...), format_status() };
+	}
+
+
+	// Overload of try_format_to for memory buffers. Nothing is appended if
+	// there is an error.
+	template<typename CharT, std::size_t InlineN, typename FormatT, typename... ValueTs>
+	format_status try_format_to(basic_memory_buffer<CharT, InlineN>& buffer, FormatT const& format_str,
+			ValueTs const& ... elements)
+	{
+		if constexpr (!internal::is_compiled_string<FormatT> && !internal::is_parsed_format<FormatT>)
 		{
-			// Return the string without modifications.
-			return format_str;
+			auto const status = internal::check_format(internal::format_view(format_str), sizeof...(elements));
+			if (!status)
+			{
+				return status;
+			}
 		}
+
+		format_to(buffer, format_str, elements...);
+		return format_status();
 	}
 
 
 	/**
-	 * The documentation of this method is the same that of: Basic Format
-	 * String page.
+	 * @page Static Strings.
 	 *
-	 * This method is overload for manage const char*. See the why is needed in
-	 * the Implicit Conversion in Template Deduction Process page.
+	 * The result of static_format: up to Capacity characters stored in the
+	 * object itself, followed by a null character. All functions can be
+	 * used in constant expressions.
+	 *
+	 * @tparam CharT Character type.
+	 * @tparam Capacity Maximum number of characters.
 	 */
-	template<typename CharT, typename... ValueTs>
-	std::basic_string<CharT> format(CharT const* format_str, ValueTs&& ... elements)
+	template<typename CharT, std::size_t Capacity>
+	struct basic_static_string
 	{
-		return format(std::basic_string_view<CharT>(format_str),
-				std::forward<ValueTs>(elements)...);
-	}
+		std::array<CharT, Capacity + 1> characters{};
+		std::size_t length = 0;
 
+		constexpr std::size_t size() const noexcept
+		{
+			return length;
+		}
 
-	// Convenience function wrapper for format_it that allows formatting a format
-	// string and values directly to an ostream.
-	//
-	// Template parameters:
-	//   CharT       Character type to generate in the output string.
-	//   Traits      Character traits to be used on the stream.
-	//   ValueTs     Types of the values to be formatted.
-	//
-	// Parameters:
-	//   ostream     Stream to write the resulting string to.
-	//   format_str  Format string to be used when formatting the string. It will
-	//               be passed to format_it directly.
-	//   elements    The elements to be formatted. They are passed to format_it
-	//               verbatim.
-	//
-	// Return value:
-	//   The ostream that was passed in.
-	//
-	// Usage example:
-	//
-	//   format(std::cout, "The first value passed is {}, and the second is {}!"s,
-	//          42, "foo");
-	//
-	template<typename CharT, typename Traits, typename... ValueTs>
-	std::basic_ostream<CharT, Traits>& format(
-			std::basic_ostream<CharT, Traits>& ostream, std::basic_string_view<CharT> format_str,
-			ValueTs&& ... elements)
-	{
-		// With this if-constexpr, We ensure that the code block will never be
-		// called with an empty argument list.
-		if constexpr (sizeof ... (elements) > 0)
+		constexpr CharT const* data() const noexcept
 		{
-			internal::format_it(std::ostream_iterator<CharT, CharT>(ostream),
-					format_str.begin(), format_str.end(),
-					std::forward<ValueTs>(elements)...);
-			return ostream;
+			return characters.data();
 		}
-		else
+
+		constexpr CharT const* c_str() const noexcept
 		{
-			return (ostream << format_str);
+			return characters.data();
 		}
-	}
 
+		constexpr std::basic_string_view<CharT> view() const noexcept
+		{
+			return std::basic_string_view<CharT>(characters.data(), length);
+		}
 
-	// Convenience function wrapper for format_it that allows formatting a format
-	// string and values directly to an ostream. (C string variant)
-	//
-	// Template parameters:
-	//   CharT       Character type to generate in the output string.
-	//   Traits      Character traits to be used on the stream.
-	//   ValueTs     Types of the values to be formatted.
-	//
-	// Parameters:
-	//   ostream     Stream to write the resulting string to.
-	//   format_str  Format string to be used when formatting the string. It will
-	//               be passed to format_it directly.
-	//   elements    The elements to be formatted. They are passed to format_it
-	//               verbatim.
-	//
-	// Return value:
-	//   The ostream that was passed in.
-	//
-	// Usage example:
-	//
-	//   format(std::cout, "The first value passed is {}, and the second is {}!"s,
-	//          42, "foo");
-	//
-	template<typename CharT, typename Traits, typename... ValueTs>
-	std::basic_ostream<CharT, Traits>& format(
-			std::basic_ostream<CharT, Traits>& ostream, CharT const* format_str,
-			ValueTs&& ... elements)
+		constexpr operator std::basic_string_view<CharT>() const noexcept
+		{
+			return view();
+		}
+	};
+
+
+	/**
+	 * @page Static Formatting.
+	 *
+	 * Format a FLOSSY_FMT string at compile time. Used to initialize a
+	 * constexpr variable, the formatting is done by the compiler and the
+	 * program only contains the resulting characters. Values can be
+	 * integers, characters and strings, floats are not supported.
+	 *
+	 * The result must fit into Capacity characters, which is checked at
+	 * compile time as well.
+	 *
+	 * @example
+	 * @code
+	 * constexpr auto banner = flossy::static_format<32>(FLOSSY_FMT("{} {}.{}"), "flossy", 1, 0);
+	 * std::fwrite(banner.data(), 1, banner.size(), stdout);
+	 * @endcode
+	 *
+	 * @tparam Capacity Maximum number of characters of the result.
+	 * @tparam S Type of the FLOSSY_FMT string.
+	 * @tparam ValueTs Types of the values to be formatted.
+	 *
+	 * @param format_str Format string created with FLOSSY_FMT.
+	 * @param elements The values to be formatted.
+	 *
+	 * @return The formatted characters.
+	 */
+	template<std::size_t Capacity, typename S, typename... ValueTs,
+			typename = std::enable_if_t<internal::is_compiled_string<S>>>
+	constexpr basic_static_string<typename internal::compiled_format<S>::char_type, Capacity>
+	static_format(S const& format_str, ValueTs const& ... elements)
 	{
-		format(ostream, std::basic_string_view<CharT>(format_str),
-				std::forward<ValueTs>(elements)...);
-		return ostream;
+		using CharT = typename internal::compiled_format<S>::char_type;
+
+		static_assert((internal::is_cheaply_sizable<CharT, ValueTs> && ...),
+				"static_format only supports integers, characters and strings");
+
+		basic_static_string<CharT, Capacity> result;
+		CharT* const first = result.characters.data();
+		auto const out = internal::format_it(internal::static_writer<CharT>(first, first + Capacity),
+				format_str, elements...);
+		result.length = std::size_t(out.get() - first);
+		return result;
 	}
 
 
 }
 
+
+// Create a format string that is parsed at compile time. The result can be
+// passed to flossy::format and flossy::internal::format_it in place of a
+// regular format string:
+//
+//   auto result = flossy::format(FLOSSY_FMT("Hello World {}."), 42);
+//
+#define FLOSSY_FMT(str) \
+	([] \
+	{ \
+		struct flossy_compiled_string : ::flossy::internal::compiled_string \
+		{ \
+			static constexpr auto value() \
+			{ \
+				return ::std::basic_string_view(str); \
+			} \
+		}; \
+		return flossy_compiled_string{}; \
+	}())
+
 #endif
@@ -0,0 +1,39 @@
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.hpp"
+
+std::size_t allocations = 0;
+void (*allocation_hook)() = nullptr;
+
+
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (allocation_hook) {
+    allocation_hook();
+  }
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  ::operator delete(p);
+}
@@ -0,0 +1,17 @@
+#ifndef FLOSSY_TEST_ALLOCATION_COUNTER_H_INCLUDED
+#define FLOSSY_TEST_ALLOCATION_COUNTER_H_INCLUDED
+
+#include <cstddef>
+
+// The tests replace the global operator new to count allocations on the
+// global heap. The replacement lives in AllocationCounter.cpp, a translation
+// unit of its own, so the compiler can't inline the malloc and free calls
+// into the tests and mistake them for mismatched allocations.
+
+// Number of allocations on the global heap so far
+extern std::size_t allocations;
+
+// Called on every allocation if set
+extern void (*allocation_hook)();
+
+#endif
@@ -0,0 +1,9 @@
+// Must not compile: the FLOSSY_FMT string has two placeholders, but only one
+// value is passed. Built by the FlossyCompileFailPlaceholderCount test, which
+// expects the static_assert message in the compiler output.
+
+#include "Flossy/Flossy.hpp"
+
+int main() {
+  return int(flossy::format(FLOSSY_FMT("{} and {}"), 1).size());
+}
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Flossy/AsyncSink.hpp"
+
+int testcount = 0;
+int failed = 0;
+
+
+void assert_equal(std::string const& description, std::string const& expect, std::string const& result) {
+  ++testcount;
+
+  if (result != expect) {
+    std::cout << "Test failed: \"" << description << "\": \"" << result << "\" != \"" << expect << "\")\n";
+    ++failed;
+  }
+}
+
+
+// Temporary file the sinks write to
+class temporary_file {
+  std::FILE* file = std::tmpfile();
+
+public:
+  ~temporary_file() {
+    std::fclose(file);
+  }
+
+  int fd() const {
+    return fileno(file);
+  }
+
+  std::string content() const {
+    std::string result;
+    std::rewind(file);
+    for (int c; (c = std::fgetc(file)) != EOF;) {
+      result += char(c);
+    }
+    return result;
+  }
+};
+
+
+struct test_struct {
+  int a;
+  int b;
+};
+
+template<typename CharT, typename OutIt>
+OutIt
+format_element(OutIt out, flossy::internal::conversion_options, test_struct const& value)
+{
+	out = flossy::internal::format_element<CharT>(out, flossy::internal::conversion_format::normal,
+			value.a);
+	out = flossy::internal::format_element<CharT>(out,
+			flossy::internal::conversion_format::character, '-');
+	out = flossy::internal::format_element<CharT>(out, flossy::internal::conversion_format::normal,
+			value.b);
+	return out;
+}
+
+
+void test_single_producer() {
+  temporary_file file;
+  std::string expect;
+
+  {
+    flossy::async_sink sink(file.fd(), 4);
+    std::string const temporary = "temporary";
+
+    for (int i = 0; i < 100; ++i) {
+      sink.format("line {} {<5s}|{.2f} {}\n", i, temporary.c_str(), i * 0.5, test_struct{ i, -i });
+      sink.format(FLOSSY_FMT("compiled {x}\n"), i);
+      expect += flossy::format("line {} {<5s}|{.2f} {}\n", i, temporary, i * 0.5, test_struct{ i, -i });
+      expect += flossy::format("compiled {x}\n", i);
+    }
+
+    sink.flush();
+    assert_equal("async_sink flush", expect, file.content());
+
+    sink.format("after flush {}\n", 42);
+    expect += "after flush 42\n";
+  }
+
+  // The destructor writes the remaining messages
+  assert_equal("async_sink destructor", expect, file.content());
+}
+
+
+void test_multiple_producers(flossy::queue_full_policy policy) {
+  temporary_file file;
+  int const threads = 4;
+  int const messages = 2000;
+  std::size_t dropped = 0;
+  std::size_t errors = 0;
+
+  {
+    flossy::async_sink sink(file.fd(), 16, policy);
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t < threads; ++t) {
+      producers.emplace_back([&sink, t] {
+        for (int i = 0; i < messages; ++i) {
+          sink.format("{} {}\n", t, i);
+        }
+      });
+    }
+
+    for (auto& producer : producers) {
+      producer.join();
+    }
+
+    sink.flush();
+    dropped = sink.dropped();
+    errors = sink.failed();
+  }
+
+  // Every message is written completely, and the messages of each thread in order
+  std::string const content = file.content();
+  std::vector<int> next(threads, 0);
+  std::size_t lines = 0;
+  bool ordered = true;
+
+  for (std::size_t start = 0; start < content.size(); ++lines) {
+    auto const end = content.find('\n', start);
+    int t = 0, i = 0;
+    std::sscanf(content.c_str() + start, "%d %d", &t, &i);
+    ordered = ordered && t >= 0 && t < threads && i >= next[t];
+    next[t] = i + 1;
+    start = end + 1;
+  }
+
+  auto const description = std::string(policy == flossy::queue_full_policy::block ? " (block)" : " (drop)");
+  assert_equal("async_sink messages" + description, std::to_string(threads * messages), std::to_string(lines + dropped));
+  assert_equal("async_sink order" + description, "true", ordered ? "true" : "false");
+  assert_equal("async_sink failures" + description, "0", std::to_string(errors));
+  if (policy == flossy::queue_full_policy::block) {
+    assert_equal("async_sink dropped" + description, "0", std::to_string(dropped));
+  }
+}
+
+
+void test_invalid_format() {
+  temporary_file file;
+  std::size_t errors = 0;
+
+  {
+    flossy::async_sink sink(file.fd());
+    sink.format("valid {}\n", 1);
+    sink.format("invalid {L}\n", 2);
+    sink.format("valid {}\n", 3);
+    sink.flush();
+    errors = sink.failed();
+  }
+
+  assert_equal("async_sink invalid format string", "valid 1\nvalid 3\n", file.content());
+  assert_equal("async_sink invalid format string failures", "1", std::to_string(errors));
+}
+
+
+// Throws when copied, like a string running out of memory would
+struct throwing_copy {
+  throwing_copy() = default;
+  throwing_copy(throwing_copy const&) {
+    throw std::runtime_error("copy failed");
+  }
+};
+
+template<typename CharT, typename OutIt>
+OutIt format_element(OutIt out, flossy::internal::conversion_options, throwing_copy const&) {
+  return out;
+}
+
+
+void test_throwing_copy() {
+  temporary_file file;
+  std::size_t errors = 0;
+  bool thrown = false;
+
+  {
+    flossy::async_sink sink(file.fd(), 4);
+    sink.format("before {}\n", 1);
+
+    try {
+      sink.format("throwing {}\n", throwing_copy());
+    } catch (std::runtime_error const&) {
+      thrown = true;
+    }
+
+    // The claimed slot must not block the following messages
+    sink.format("after {}\n", 2);
+    sink.flush();
+    errors = sink.failed();
+  }
+
+  assert_equal("async_sink throwing copy rethrown", "true", thrown ? "true" : "false");
+  assert_equal("async_sink throwing copy", "before 1\nafter 2\n", file.content());
+  assert_equal("async_sink throwing copy failures", "1", std::to_string(errors));
+}
+
+
+// Formatting throws on the background thread, with a type not derived from
+// std::exception
+struct throwing_format {
+};
+
+template<typename CharT, typename OutIt>
+OutIt format_element(OutIt out, flossy::internal::conversion_options, throwing_format const&) {
+  throw 42;
+  return out;
+}
+
+
+void test_throwing_format() {
+  temporary_file file;
+  std::size_t errors = 0;
+
+  {
+    flossy::async_sink sink(file.fd(), 4);
+    sink.format("before {}\n", 1);
+    sink.format("throwing {}\n", throwing_format());
+    sink.format("after {}\n", 2);
+    sink.flush();
+    errors = sink.failed();
+  }
+
+  assert_equal("async_sink throwing format", "before 1\nafter 2\n", file.content());
+  assert_equal("async_sink throwing format failures", "1", std::to_string(errors));
+}
+
+
+int main() {
+  test_single_producer();
+  test_multiple_producers(flossy::queue_full_policy::block);
+  test_multiple_producers(flossy::queue_full_policy::drop);
+  test_invalid_format();
+  test_throwing_copy();
+  test_throwing_format();
+
+  std::cout << "Performed " << testcount << " tests, " << (testcount - failed) << " passed, " << failed << " failed." << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "Flossy/BinaryLog.hpp"
+#include "AllocationCounter.hpp"
+
+int testcount = 0;
+int failed = 0;
+
+
+void assert_equal(std::string const& description, std::string const& expect, std::string const& result) {
+  ++testcount;
+
+  if (result != expect) {
+    std::cout << "Test failed: \"" << description << "\": \"" << result << "\" != \"" << expect << "\")\n";
+    ++failed;
+  }
+}
+
+
+// Temporary file the writers write to
+class temporary_file {
+  std::FILE* file = std::tmpfile();
+
+public:
+  ~temporary_file() {
+    std::fclose(file);
+  }
+
+  int fd() const {
+    return fileno(file);
+  }
+
+  std::string content() const {
+    std::string result;
+    std::rewind(file);
+    for (int c; (c = std::fgetc(file)) != EOF;) {
+      result += char(c);
+    }
+    return result;
+  }
+};
+
+
+// Write the message to the binary log and format it directly for comparison
+template<typename FormatT, typename... ValueTs>
+void log(flossy::binary_writer& writer, std::string& expect, FormatT const& format_str, ValueTs const& ... values) {
+  writer.format(format_str, values...);
+  expect += flossy::format(format_str, values...);
+}
+
+
+std::string decode(std::string const& stream, std::size_t piece_size) {
+  flossy::binary_reader reader;
+  std::string result;
+  std::string pending;
+
+  for (std::size_t start = 0; start < stream.size(); start += piece_size) {
+    pending += stream.substr(start, piece_size);
+    std::string_view bytes = pending;
+    reader.decode(std::back_inserter(result), bytes);
+    pending = std::string(bytes);
+  }
+
+  if (!pending.empty()) {
+    result += "<incomplete>";
+  }
+  return result;
+}
+
+
+void test_values(std::size_t capacity) {
+  temporary_file file;
+  std::string expect;
+  std::string const description = " (buffer of " + std::to_string(capacity) + " bytes)";
+
+  {
+    flossy::binary_writer writer(file.fd(), capacity);
+    std::string const text = "string value";
+    std::string const long_text(1000, 'x');
+
+    log(writer, expect, "no values\n");
+    log(writer, expect, "integers {} {} {} {} {} {}\n", std::int8_t(-8), std::int16_t(-16), -32, -64LL, 'c', true);
+    log(writer, expect, "unsigned {} {} {} {}\n", std::uint8_t(8), std::uint16_t(16), 32U,
+        std::numeric_limits<unsigned long long>::max());
+    log(writer, expect, "hex {x} {x} {x} {b}\n", std::int8_t(-1), std::int16_t(-1), -1, -1LL);
+    log(writer, expect, "padded {<8d}|{>+8d}|{ 10x}|{_010d}\n", 42, 42, 255, -7);
+    log(writer, expect, "floats {} {} {} {.2f} {.3e} {+f}\n", 0.1f, 1e300, 2.5L, 3.14159, 123456.789, -0.0);
+    log(writer, expect, "floats {} {} {}\n", std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::denorm_min());
+    log(writer, expect, "strings {} {<20s}|{} {}\n", "literal", text, std::string_view(text).substr(7), text.c_str());
+    log(writer, expect, "long string {}\n", long_text);
+    log(writer, expect, "braces {{}} {} rest {} {{\n", 1);
+    log(writer, expect, FLOSSY_FMT("compiled {} {x}\n"), 1, 255);
+
+    for (int i = 0; i < 100; ++i) {
+      log(writer, expect, "repeated {} {.1f}\n", i, i * 0.5);
+    }
+  }
+
+  std::string const stream = file.content();
+  assert_equal("binary_reader" + description, expect, decode(stream, stream.size()));
+  assert_equal("binary_reader in pieces" + description, expect, decode(stream, 7));
+  assert_equal("binary_reader in bytes" + description, expect, decode(stream, 1));
+}
+
+
+void test_format_records() {
+  temporary_file file;
+
+  {
+    flossy::binary_writer writer(file.fd());
+    for (int i = 0; i < 10; ++i) {
+      writer.format("same format string {}\n", i);
+    }
+  }
+
+  // The format string is only written once
+  std::string const stream = file.content();
+  std::size_t count = 0;
+  for (auto position = stream.find("same format"); position != std::string::npos;
+       position = stream.find("same format", position + 1)) {
+    ++count;
+  }
+  assert_equal("binary_writer format records", "1", std::to_string(count));
+}
+
+
+void test_no_allocations() {
+  temporary_file file;
+  flossy::binary_writer writer(file.fd(), 256);
+  std::string const text = "string value";
+
+  writer.format("warm up {}\n", 1);
+  auto const before = allocations;
+  for (int i = 0; i < 1000; ++i) {
+    writer.format("value {} {} {} {}\n", i, i * 0.25, text, "literal");
+  }
+  assert_equal("binary_writer allocations", "0", std::to_string(allocations - before));
+}
+
+
+void test_invalid_stream() {
+  flossy::binary_reader reader;
+  std::string result;
+  std::string_view bytes = "not a binary log";
+
+  try {
+    reader.decode(std::back_inserter(result), bytes);
+    assert_equal("binary_reader invalid stream", "exception", "no exception");
+  }
+  catch (std::invalid_argument const&) {
+    assert_equal("binary_reader invalid stream", "exception", "exception");
+  }
+}
+
+
+int main() {
+  test_values(65536);
+  test_values(64);
+  test_format_records();
+  test_no_allocations();
+  test_invalid_stream();
+
+  std::cout << "Performed " << testcount << " tests, " << (testcount - failed) << " passed, " << failed << " failed." << std::endl;
+  return failed ? 1 : 0;
+}
@@ -1,8 +1,11 @@
 #include <limits>
 #include <string>
+#include <vector>
+#include <cstdlib>
 #include <iostream>
 
 #include "Flossy/Flossy.hpp"
+#include "AllocationCounter.hpp"
 
 int testcount = 0;
 int failed = 0;
@@ -40,6 +43,27 @@ void test_format_it(std::string expect, std::string format, Args&&... args) {
   auto conv_expect = cheaty_cast_string<CharT>(expect);
   auto conv_format = cheaty_cast_string<CharT>(format);
 
+  // Output to contiguous memory takes different code paths
+  CharT buffer[512];
+  CharT* end = flossy::internal::format_it(&buffer[0], conv_format.begin(), conv_format.end(), args...);
+  assert_equal("Format string to pointer (" + format + ")", conv_expect, std::basic_string<CharT>(buffer, end));
+
+  // Strings and vectors are appended to in bulk
+  std::vector<CharT> vector_output;
+  flossy::internal::format_it(std::back_inserter(vector_output), conv_format.begin(), conv_format.end(), args...);
+  assert_equal("Format string to vector (" + format + ")", conv_expect,
+               std::basic_string<CharT>(vector_output.begin(), vector_output.end()));
+
+  assert_equal<char>("Formatted size (" + format + ")", std::to_string(conv_expect.size()),
+                     std::to_string(flossy::formatted_size(conv_format, args...)));
+  assert_equal("flossy::format (" + format + ")", conv_expect, flossy::format(conv_format, args...));
+
+  // Type-erased values
+  std::basic_string<CharT> vformat_output;
+  using OutIt = std::back_insert_iterator<std::basic_string<CharT>>;
+  flossy::vformat(std::back_inserter(vformat_output), conv_format, flossy::make_format_args<CharT, OutIt>(args...));
+  assert_equal("vformat (" + format + ")", conv_expect, vformat_output);
+
   std::basic_string<CharT> output;
   flossy::internal::format_it(std::back_inserter(output), conv_format.begin(), conv_format.end(),
 		  std::forward<Args>(args)...);
@@ -47,6 +71,79 @@ void test_format_it(std::string expect, std::string format, Args&&... args) {
 }
 
 
+// Parsed format strings are parsed once in advance, but must produce the same
+// output as the format strings parsed while formatting.
+template<typename CharT, typename... Args>
+void test_parsed_format(std::string expect, std::string format, Args&&... args) {
+  auto conv_expect = cheaty_cast_string<CharT>(expect);
+  flossy::parsed_format<CharT> const parsed(cheaty_cast_string<CharT>(format));
+
+  std::basic_string<CharT> output;
+  flossy::internal::format_it(std::back_inserter(output), parsed, std::forward<Args>(args)...);
+  assert_equal("Parsed format string (" + format + ")", conv_expect, output);
+  assert_equal<char>("Parsed formatted size (" + format + ")", std::to_string(conv_expect.size()),
+                     std::to_string(flossy::formatted_size(parsed, args...)));
+
+  // Formatting with the same object again must give the same result
+  assert_equal("Parsed format string reused (" + format + ")", conv_expect,
+               flossy::format(parsed, std::forward<Args>(args)...));
+}
+
+
+// Parsed format strings checked for the number of values use a different
+// formatting loop, but must produce the same output.
+template<typename CharT, typename... Args>
+void test_checked_format(std::string expect, std::string format, Args&&... args) {
+  auto conv_expect = cheaty_cast_string<CharT>(expect);
+  flossy::parsed_format<CharT, sizeof...(Args)> const checked(cheaty_cast_string<CharT>(format));
+
+  std::basic_string<CharT> output;
+  flossy::internal::format_it(std::back_inserter(output), checked, std::forward<Args>(args)...);
+  assert_equal("Checked format string (" + format + ")", conv_expect, output);
+  assert_equal<char>("Checked formatted size (" + format + ")", std::to_string(conv_expect.size()),
+                     std::to_string(flossy::formatted_size(checked, args...)));
+}
+
+
+// Compiled format strings are parsed at compile time, but must produce the
+// same output as the format strings parsed while formatting.
+template<typename S, typename... Args>
+void test_compiled_format(std::string expect, S format, Args&&... args) {
+  using CharT = typename flossy::internal::compiled_format<S>::char_type;
+
+  auto conv_expect = cheaty_cast_string<CharT>(expect);
+  auto description = cheaty_cast_string<char>(std::basic_string<CharT>(S::value()));
+
+  std::basic_string<CharT> output;
+  flossy::internal::format_it(std::back_inserter(output), format, std::forward<Args>(args)...);
+  assert_equal("Compiled format string (" + description + ")", conv_expect, output);
+  assert_equal<char>("Compiled formatted size (" + description + ")", std::to_string(conv_expect.size()),
+                     std::to_string(flossy::formatted_size(format, args...)));
+  assert_equal("flossy::format (" + description + ")", conv_expect, flossy::format(format, args...));
+}
+
+
+// Format into buffers of all sizes up to the length of the expected output,
+// checking the truncated output and the reported sizes.
+template<typename CharT, typename Format, typename... Args>
+void test_format_to_n(std::string expect, std::string description, Format const& format, Args const&... args) {
+  auto conv_expect = cheaty_cast_string<CharT>(expect);
+
+  for (std::size_t n = 0; n <= conv_expect.size() + 1; ++n) {
+    // One more character, which must not be written to
+    std::vector<CharT> buffer(n + 1, CharT('#'));
+    auto const result = flossy::format_to_n(buffer.data(), n, format, args...);
+    auto const written = std::min(n, conv_expect.size());
+
+    auto const size_description = " (" + description + ", " + std::to_string(n) + ")";
+    assert_equal<char>("format_to_n written" + size_description, std::to_string(written), std::to_string(result.written));
+    assert_equal<char>("format_to_n size" + size_description, std::to_string(conv_expect.size()), std::to_string(result.size));
+    assert_equal("format_to_n output" + size_description, conv_expect.substr(0, written) + CharT('#'),
+                 std::basic_string<CharT>(buffer.data(), written + 1));
+  }
+}
+
+
 template<typename CharT>
 void test_fixed_float_alignment() {
   // Alignment of negative floats (fixed)
@@ -328,6 +425,62 @@ void test_float_specials() {
 }
 
 
+template<typename CharT>
+void test_shortest_float() {
+  // The 'r' type gives the shortest representation reading back to the same value
+  test_format_it<CharT>("0",            "{r}",  0.0);
+  test_format_it<CharT>("-0",           "{r}",  -0.0);
+  test_format_it<CharT>("0.1",          "{r}",  0.1);
+  test_format_it<CharT>("0.1",          "{r}",  0.1f);
+  test_format_it<CharT>("-1.5",         "{r}",  -1.5);
+  test_format_it<CharT>("42.133724",    "{r}",  42.133724f);
+  test_format_it<CharT>("100",          "{r}",  100.0);
+  test_format_it<CharT>("1e+16",        "{r}",  1e16);
+  test_format_it<CharT>("1e-05",        "{r}",  1e-5);
+  test_format_it<CharT>("1e-04",        "{r}",  1e-4);
+  test_format_it<CharT>("0.001",        "{r}",  1e-3);
+  test_format_it<CharT>("5e-324",       "{r}",  5e-324);
+  test_format_it<CharT>("1.7976931348623157e+308", "{r}", std::numeric_limits<double>::max());
+  test_format_it<CharT>("123456789012345680", "{r}", 123456789012345678.0);
+  test_format_it<CharT>("1152921504606846976", "{r}", 1152921504606846976.0);
+  test_format_it<CharT>("inf",          "{r}",  std::numeric_limits<double>::infinity());
+
+  // Alignment and signs work as usual, the precision is ignored
+  test_format_it<CharT>("  +0.25", "{+7r}",  0.25);
+  test_format_it<CharT>("-000.25", "{_07r}", -0.25);
+  test_format_it<CharT>("0.25",    "{.2r}",  0.25);
+
+  // Without type, floats keep the fixed notation with a precision of 6
+  test_format_it<CharT>("0.100000", "{}",   0.1);
+  test_format_it<CharT>("100000000000000000000.000000", "{}", 1e20);
+  test_format_it<CharT>("0.100",    "{.3}", 0.1);
+}
+
+
+#if FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_FAST
+template<typename CharT>
+void test_fast_float() {
+  test_format_it<CharT>("0.00",      "{.2f}",   0.0);
+  test_format_it<CharT>("-0.00",     "{.2f}",   -0.0);
+  test_format_it<CharT>("0.05",      "{.2f}",   0.049999);
+  test_format_it<CharT>("1.00",      "{.2f}",   0.999);
+  test_format_it<CharT>("-12.3400",  "{.4f}",   -12.34);
+  test_format_it<CharT>("+0012.340", "{_+09.3}", 12.34);
+
+  // Values out of range fall back to the precise method
+  test_format_it<CharT>("100000000000000000000.00", "{.2f}", 1e20);
+  test_format_it<CharT>("0.1000000000000000055511", "{.22f}", 0.1);
+  test_format_it<CharT>("4503599627370497", "{.0f}", 4503599627370497.0);
+  test_format_it<CharT>("7641663221391731", "{.0f}", 7641663221391731.0);
+
+  // So do values too close to halfway between two outputs
+  test_format_it<CharT>("0",         "{.0f}",   0.49999999999999994);
+  test_format_it<CharT>("2",         "{.0f}",   2.5);
+  test_format_it<CharT>("0.1",       "{.1f}",   0.15);
+}
+#endif
+
+
 template<typename CharT>
 void test_float_formatters() {
   test_fixed_float_alignment<CharT>();
@@ -335,6 +488,10 @@ void test_float_formatters() {
   test_fixed_float_precision<CharT>();
   test_scientific_float_precision<CharT>();
   test_float_specials<CharT>();
+  test_shortest_float<CharT>();
+#if FLOSSY_FLOAT_METHOD == FLOSSY_FLOAT_METHOD_FAST
+  test_fast_float<CharT>();
+#endif
 }
 
 
@@ -405,6 +562,10 @@ void test_int_alignment() {
   test_format_it<CharT>("   42", "{> 05d}",  42U);
   test_format_it<CharT>(" 0042", "{_ 05d}",  42U);
   test_format_it<CharT>(" 42  ", "{< 05d}",  42U);
+
+  // Widths beyond the largest supported one are clamped
+  assert_equal<char>("Clamped width", "32767",
+                     std::to_string(flossy::format(cheaty_cast_string<CharT>("{99999999999d}"), -1).size()));
 }
 
 
@@ -440,13 +601,74 @@ void test_int_bases() {
   test_format_it<CharT>("1111111111010110",                                                 "{b}", int16_t(-42));
   test_format_it<CharT>("11111111111111111111111111010110",                                 "{b}", int32_t(-42));
   test_format_it<CharT>("1111111111111111111111111111111111111111111111111111111111010110", "{b}", int64_t(-42));
+
+  // Extremes of the different integer bases
+  test_format_it<CharT>("0",                "{x}", uint32_t(0));
+  test_format_it<CharT>("0",                "{x}", uint64_t(0));
+  test_format_it<CharT>("f",                "{x}", uint32_t(0xf));
+  test_format_it<CharT>("10",               "{x}", uint64_t(0x10));
+  test_format_it<CharT>("ff",               "{x}", std::numeric_limits<uint8_t>::max());
+  test_format_it<CharT>("ffffffff",         "{x}", std::numeric_limits<uint32_t>::max());
+  test_format_it<CharT>("ffffffffffffffff", "{x}", std::numeric_limits<uint64_t>::max());
+  test_format_it<CharT>("8000000000000000", "{x}", std::numeric_limits<int64_t>::min());
+  test_format_it<CharT>("deadbeef",         "{x}", uint64_t(0xdeadbeef));
+  test_format_it<CharT>("0000abcd",         "{_08x}", uint32_t(0xabcd));
+  test_format_it<CharT>("abcd    ",         "{<8x}",  uint64_t(0xabcd));
+  test_format_it<CharT>("0",                "{o}", 0U);
+  test_format_it<CharT>("1777777777777777777777", "{o}", std::numeric_limits<uint64_t>::max());
+  test_format_it<CharT>("0",                "{b}", 0U);
+  test_format_it<CharT>("11111111",         "{b}", std::numeric_limits<uint8_t>::max());
+}
+
+
+template<typename CharT>
+void test_int_decimal() {
+  // Decimal numbers of every length (converted two digits at a time)
+  test_format_it<CharT>("0",                    "{}", 0U);
+  test_format_it<CharT>("9",                    "{}", 9U);
+  test_format_it<CharT>("10",                   "{}", 10U);
+  test_format_it<CharT>("99",                   "{}", 99U);
+  test_format_it<CharT>("100",                  "{}", 100U);
+  test_format_it<CharT>("255",                  "{}", std::numeric_limits<uint8_t>::max());
+  test_format_it<CharT>("65535",                "{}", std::numeric_limits<uint16_t>::max());
+  test_format_it<CharT>("4294967295",           "{}", std::numeric_limits<uint32_t>::max());
+  test_format_it<CharT>("18446744073709551615", "{}", std::numeric_limits<uint64_t>::max());
+  test_format_it<CharT>("127",                  "{}", std::numeric_limits<int8_t>::max());
+  test_format_it<CharT>("9223372036854775807",  "{}", std::numeric_limits<int64_t>::max());
+  test_format_it<CharT>("-1000000007",          "{d}", -1000000007);
+  test_format_it<CharT>("1020304050607080900",  "{d}", 1020304050607080900ULL);
+}
+
+
+#ifdef __SIZEOF_INT128__
+// 128 bit integers are only integral types with GNU extensions (gnu++17)
+__extension__ typedef __int128 int128_type;
+__extension__ typedef unsigned __int128 uint128_type;
+
+template<typename CharT, typename ValueT = int128_type, typename UnsignedT = uint128_type>
+void test_int128() {
+  if constexpr (std::is_integral<ValueT>::value) {
+    ValueT const value = ValueT(1) << 80;
+    test_format_it<CharT>("1208925819614629174706176",  "{}",   value);
+    test_format_it<CharT>("-1208925819614629174706176", "{}",   -value);
+    test_format_it<CharT>("100000000000000000000",      "{x}",  value);
+    test_format_it<CharT>("  +1208925819614629174706176", "{+28d}", value);
+    test_format_it<CharT>("340282366920938463463374607431768211455", "{}", ~UnsignedT(0));
+    test_format_it<CharT>("1" + std::string(100, '0'), "{b}", ValueT(1) << 100);
+    test_format_it<CharT>("3" + std::string(42, '7'), "{o}", ~UnsignedT(0));
+  }
 }
+#endif
 
 
 template<typename CharT>
 void test_int_formatters() {
   test_int_alignment<CharT>();
   test_int_bases<CharT>();
+  test_int_decimal<CharT>();
+#ifdef __SIZEOF_INT128__
+  test_int128<CharT>();
+#endif
 }
 
 
@@ -478,6 +700,17 @@ void test_multiple_formatters() {
   test_format_it<CharT>("AAfooXX42YYbarBB", "AA{}XX{}YY{}BB", cheaty_cast_string<CharT>("foo"), 42, cheaty_cast_string<CharT>("bar"));
 }
 
+
+template<typename CharT>
+void test_long_literals() {
+  // Braces at every position of the blocks scanned at once
+  for (std::size_t length = 0; length <= 70; ++length) {
+    std::string const text(length, 'a');
+    test_format_it<CharT>(text + "{" + text + "42" + text, text + "{{" + text + "{}" + text, 42);
+    test_format_it<CharT>(text + "{}", text + "{}");
+  }
+}
+
 template<typename CharT>
 void test_empty_var_arguments() {
 	test_format_it<CharT>("{}", "{}");
@@ -494,12 +727,216 @@ void test_empty_var_arguments() {
 }
 
 
+void test_compiled_formats() {
+  test_compiled_format("AAfooXX42YYbarBB", FLOSSY_FMT("AA{}XX{}YY{}BB"), "foo", 42, "bar");
+  test_compiled_format("AAfooXX42YYbarBB", FLOSSY_FMT(L"AA{}XX{}YY{}BB"), L"foo", 42, L"bar");
+  test_compiled_format("AAfooXX42YYbarBB", FLOSSY_FMT(U"AA{}XX{}YY{}BB"), U"foo", 42, U"bar");
+
+  test_compiled_format("+0042",      FLOSSY_FMT("{_+05d}"), 42);
+  test_compiled_format("-42  ",      FLOSSY_FMT("{<5d}"),   -42);
+  test_compiled_format("ffffffd6",   FLOSSY_FMT("{x}"),     int32_t(-42));
+  test_compiled_format("1.235",      FLOSSY_FMT("{.3f}"),   1.234567890);
+  test_compiled_format("yyy       ", FLOSSY_FMT("{<10s}"),  "yyy");
+  test_compiled_format("f",          FLOSSY_FMT("{c}"),     'f');
+
+  // Escaped braces, the text after the last value is copied verbatim
+  test_compiled_format("{42}}",              FLOSSY_FMT("{{{}}}"),             42);
+  test_compiled_format("{}} 42 {}} 7",       FLOSSY_FMT("{{}} {} {{}} {}"),    42, 7);
+  test_compiled_format("AA1XX2YY{{}}",       FLOSSY_FMT("AA{}XX{}YY{{}}"),     1, 2);
+  test_compiled_format("AA{{BB",             FLOSSY_FMT("AA{{BB"));
+
+  // Checked for the number of values at compile time
+  flossy::parsed_format<char, 2> const checked(FLOSSY_FMT("AA{}XX{x}{{BB"));
+  assert_equal<char>("Checked compiled format string", "AA1XXff{{BB", flossy::format(checked, 1, 255));
+  flossy::parsed_format<wchar_t> const unchecked(FLOSSY_FMT(L"AA{}XX{x}{{BB"));
+  assert_equal<wchar_t>("Unchecked compiled format string", L"AA1XX{x}{{BB", flossy::format(unchecked, 1));
+}
+
+
+// Formatted by the compiler, but must produce the same output as format
+template<std::size_t Capacity, typename S, typename... Args>
+void test_static_format(S format, Args&&... args) {
+  using CharT = typename flossy::internal::compiled_format<S>::char_type;
+
+  auto const result = flossy::static_format<Capacity>(format, args...);
+  assert_equal<CharT>("static_format", flossy::format(format, args...), std::basic_string<CharT>(result.view()));
+  assert_equal<char>("static_format null terminated", "0", std::to_string(int(result.c_str()[result.size()])));
+}
+
+
+void test_static_formats() {
+  constexpr auto banner = flossy::static_format<32>(FLOSSY_FMT("{} {}.{}"), "flossy", 1, 0);
+  static_assert(banner.view() == "flossy 1.0");
+
+  constexpr auto wide = flossy::static_format<16>(FLOSSY_FMT(L"{x}|{<4s}|"), 255U, L"ab");
+  static_assert(wide.view() == L"ff|ab  |");
+
+  test_static_format<64>(FLOSSY_FMT("AA{}XX{_+08d}YY{<6s}BB{x}{o}{b}"), "foo", 42, "bar", 0xdeadbeefU, 8, 5);
+  test_static_format<64>(FLOSSY_FMT("{} {} {} {c} {> 5} {}"), std::numeric_limits<int64_t>::min(),
+                         std::numeric_limits<uint64_t>::max(), 'x', 'y', 42, std::string_view("view"));
+  test_static_format<16>(FLOSSY_FMT("{{{}}} {{x}}"), 42);
+  test_static_format<8>(FLOSSY_FMT(U"{}|{5x}"), 1, 255);
+  test_static_format<4>(FLOSSY_FMT("AA{}"), 1);
+}
+
+
+template<typename CharT>
+void test_parsed_formats() {
+  test_parsed_format<CharT>("AAfooXX42YYbarBB", "AA{}XX{}YY{}BB", cheaty_cast_string<CharT>("foo"), 42, cheaty_cast_string<CharT>("bar"));
+  test_parsed_format<CharT>("+0042",            "{_+05d}", 42);
+  test_parsed_format<CharT>("ffffffd6",         "{x}",     int32_t(-42));
+  test_parsed_format<CharT>("1.235",            "{.3f}",   1.234567890);
+  test_parsed_format<CharT>("   4.213372e+01",  "{15e}",   42.133724f);
+
+  // Escaped braces and running out of values
+  test_parsed_format<CharT>("{42}}",            "{{{}}}",          42);
+  test_parsed_format<CharT>("{}} 42 {{}} {}",   "{{}} {} {{}} {}", 42);
+  test_parsed_format<CharT>("AA{}XX{}YY{}BB",   "AA{}XX{}YY{}BB");
+  test_parsed_format<CharT>("AA1XX{}YY{{}}{}",  "AA{}XX{}YY{{}}{}", 1);
+
+  // Invalid format strings are rejected when parsing, even without values
+  for (auto const format : { "{", "AA{}XX{L}", "{10" }) {
+    ++testcount;
+    try {
+      flossy::parsed_format<CharT> const parsed(cheaty_cast_string<CharT>(format));
+      std::cout << "Test failed: \"Parsed format string (" << format << ")\" did not throw\n";
+      ++failed;
+    }
+    catch (std::invalid_argument const&) {
+    }
+  }
+
+  test_checked_format<CharT>("AAfooXX42YYbarBB", "AA{}XX{}YY{}BB", cheaty_cast_string<CharT>("foo"), 42, cheaty_cast_string<CharT>("bar"));
+  test_checked_format<CharT>("+0042",            "{_+05d}", 42);
+  test_checked_format<CharT>("1.235",            "{.3f}",   1.234567890);
+  test_checked_format<CharT>("AA{{}}",           "AA{{}}");
+
+  // Braces are only unescaped up to the last value, like above
+  test_checked_format<CharT>("{42}}",            "{{{}}}",          42);
+  test_checked_format<CharT>("{}} 42 {}} 43",    "{{}} {} {{}} {}", 42, 43);
+  test_checked_format<CharT>("1 {{x}}",          "{} {{x}}",        1);
+
+  // The number of placeholders must match the number of values
+  for (auto const format : { "{}", "{} {} {}", "{{}} {{}}", "{} {" }) {
+    ++testcount;
+    try {
+      flossy::parsed_format<CharT, 2> const checked(cheaty_cast_string<CharT>(format));
+      std::cout << "Test failed: \"Checked format string (" << format << ")\" did not throw\n";
+      ++failed;
+    }
+    catch (std::invalid_argument const&) {
+    }
+  }
+}
+
+
+// check_format and try_format_to report the errors format throws for
+template<typename CharT>
+void test_format_errors() {
+  struct invalid_format {
+    char const* format;
+    std::size_t offset;
+  };
+
+  for (auto const invalid : { invalid_format{ "{", 0 }, invalid_format{ "AA{}XX{L}", 7 },
+                              invalid_format{ "AA{10", 2 }, invalid_format{ "{}{{{_+010.3x!}", 13 } }) {
+    auto const format = cheaty_cast_string<CharT>(invalid.format);
+    auto const status = flossy::check_format(format);
+    assert_equal<char>("check_format offset (" + std::string(invalid.format) + ")",
+                       std::to_string(invalid.offset), status ? "valid" : std::to_string(status.offset));
+
+    std::string message = "none";
+    try {
+      flossy::format(format, 1, 2);
+    }
+    catch (std::invalid_argument const& error) {
+      message = error.what();
+    }
+    assert_equal<char>("check_format message (" + std::string(invalid.format) + ")", message, status.message());
+
+    std::basic_string<CharT> output;
+    auto const result = flossy::try_format_to(std::back_inserter(output), format, 1, 2);
+    assert_equal<char>("try_format_to status (" + std::string(invalid.format) + ")", message, result.status.message());
+    assert_equal("try_format_to output (" + std::string(invalid.format) + ")", std::basic_string<CharT>(), output);
+  }
+
+  assert_equal<char>("check_format (valid)", "valid",
+                     flossy::check_format(cheaty_cast_string<CharT>("AA{}XX{{}}{_+010.3x}")) ? "valid" : "invalid");
+
+  // Like format, the text following the last value is not checked
+  std::basic_string<CharT> output;
+  auto const result = flossy::try_format_to(std::back_inserter(output), cheaty_cast_string<CharT>("AA{}XX{L}"), 1);
+  assert_equal("try_format_to (rest copied)", cheaty_cast_string<CharT>("AA1XX{L}"), output);
+  assert_equal<char>("try_format_to (rest copied) status", "valid", result.status ? "valid" : "invalid");
+}
+
+
+template<typename CharT>
+void test_format_to_n_buffers() {
+  auto const format = cheaty_cast_string<CharT>("AA{}XX{_+08d}YY{<6s}{.2f}BB{x}");
+  auto const foo = cheaty_cast_string<CharT>("foo");
+  std::string const expect = "AAfooXX+0000042YYfoo   1.25BBff";
+
+  test_format_to_n<CharT>(expect, "string", format, foo, 42, foo, 1.25, 255);
+  test_format_to_n<CharT>(expect, "C string", format.c_str(), foo, 42, foo, 1.25, 255);
+  test_format_to_n<CharT>(expect, "parsed", flossy::parsed_format<CharT>(format), foo, 42, foo, 1.25, 255);
+
+  // Running out of values
+  test_format_to_n<CharT>("AAfooXX{_+08d}YY{<6s}{.2f}BB{x}", "string", format, foo);
+  test_format_to_n<CharT>("AAfooXX{_+08d}YY{<6s}{.2f}BB{x}", "parsed", flossy::parsed_format<CharT>(format), foo);
+}
+
+
+template<typename CharT>
+void test_memory_buffers() {
+  auto const foo = cheaty_cast_string<CharT>("foo");
+  auto const format = cheaty_cast_string<CharT>("AA{}XX{_+08d}YY{<6s}");
+  std::string const expect = "AAfooXX+0000042YYfoo   ";
+
+  // Small inline capacity, so appending spills to the heap
+  flossy::basic_memory_buffer<CharT, 16> buffer;
+  assert_equal("format_to memory buffer", cheaty_cast_string<CharT>(expect),
+               std::basic_string<CharT>(flossy::format_to(buffer, format, foo, 42, foo)));
+  flossy::format_to(buffer, format.c_str(), foo, 42, foo);
+  assert_equal("format_to memory buffer (appended)", cheaty_cast_string<CharT>(expect + expect), buffer.str());
+  assert_equal<char>("memory buffer capacity", "true", buffer.capacity() > 16 ? "true" : "false");
+
+  // Cleared buffers keep their memory
+  auto const capacity = buffer.capacity();
+  buffer.clear();
+  flossy::format_to(buffer, flossy::parsed_format<CharT>(format), foo, 42, foo);
+  assert_equal("format_to memory buffer (parsed)", cheaty_cast_string<CharT>(expect), buffer.str());
+  assert_equal<char>("memory buffer capacity (cleared)", std::to_string(capacity), std::to_string(buffer.capacity()));
+
+  // Values that are not cheaply sizable are appended through a back_inserter
+  buffer.clear();
+  flossy::format_to(buffer, format, foo, 1.5, foo);
+  assert_equal("format_to memory buffer (float)", cheaty_cast_string<CharT>("AAfooXX+1.500000YYfoo   "), buffer.str());
+
+  flossy::basic_memory_buffer<CharT, 16> moved(std::move(buffer));
+  assert_equal("memory buffer (moved)", cheaty_cast_string<CharT>("AAfooXX+1.500000YYfoo   "), moved.str());
+
+  flossy::basic_memory_buffer<CharT, 64> inline_buffer;
+  flossy::internal::format_it(std::back_inserter(inline_buffer), format.begin(), format.end(), foo, 42, foo);
+  assert_equal("format_it memory buffer", cheaty_cast_string<CharT>(expect), inline_buffer.str());
+  assert_equal<char>("memory buffer capacity (inline)", "64", std::to_string(inline_buffer.capacity()));
+
+  flossy::basic_memory_buffer<CharT, 64> moved_inline(std::move(inline_buffer));
+  assert_equal("memory buffer (moved inline)", cheaty_cast_string<CharT>(expect), moved_inline.str());
+}
+
+
 template<typename CharT>
 void run_tests() {
   // Test formatter function with iterators
   test_empty_var_arguments<CharT>();
   test_basic_formatters<CharT>();
   test_multiple_formatters<CharT>();
+  test_long_literals<CharT>();
+  test_parsed_formats<CharT>();
+  test_format_errors<CharT>();
+  test_format_to_n_buffers<CharT>();
+  test_memory_buffers<CharT>();
 }
 
 
@@ -550,9 +987,93 @@ int main() {
     assert_equal<wchar_t>("void flossy::format(wostringstream&, string)", L"foo", tmp.str());
   }
 
+  {
+    // Output larger than the buffer used for streams
+    std::string const long_str(1000, 'x');
+    std::ostringstream tmp;
+    flossy::format(tmp, std::string("{}|{1200}|{}"), long_str, "foo", 42);
+    assert_equal<char>("void flossy::format(ostringstream&, string) (long)",
+                       long_str + "|" + std::string(1197, ' ') + "foo|42", tmp.str());
+
+    std::ostringstream compiled;
+    flossy::format(compiled, FLOSSY_FMT("{}|{1200}|{}"), long_str, "foo", 42);
+    assert_equal<char>("void flossy::format(ostringstream&, FLOSSY_FMT) (long)", tmp.str(), compiled.str());
+
+    std::ostringstream parsed;
+    flossy::format(parsed, flossy::parsed_format<char>("{}|{1200}|{}"), long_str, "foo", 42);
+    assert_equal<char>("void flossy::format(ostringstream&, parsed_format) (long)", tmp.str(), parsed.str());
+  }
+
+  {
+    // Nothing is written to streams in a failed state
+    std::ostringstream tmp;
+    tmp.setstate(std::ios_base::failbit);
+    flossy::format(tmp, "{}", "foo");
+    assert_equal<char>("void flossy::format(ostringstream&, string) (failed)", "", tmp.str());
+  }
+
+  {
+    // The output up to an invalid conversion specifier is still written
+    std::ostringstream tmp;
+    try {
+      flossy::format(tmp, "foo{}bar{L}", 42, 43);
+    }
+    catch (std::invalid_argument const&) {
+    }
+    assert_equal<char>("void flossy::format(ostringstream&, string) (invalid)", "foo42bar", tmp.str());
+  }
+
   test_struct test { 42, 1337 };
   test_format_it<char>("42-1337", "{}", test);
   test_format_it<wchar_t>("42-1337", "{}", test);
+  test_compiled_format("42-1337", FLOSSY_FMT("{}"), test);
+  test_parsed_format<char>("42-1337", "{}", test);
+
+  test_compiled_formats();
+  test_static_formats();
+  test_format_to_n<char>("AA-42XX  foo", "compiled", FLOSSY_FMT("AA{}XX{5s}"), -42, "foo");
+  assert_equal<char>("string flossy::format(FLOSSY_FMT)", "foo42", flossy::format(FLOSSY_FMT("foo{}"), 42));
+
+  flossy::memory_buffer buffer;
+  assert_equal<char>("format_to memory buffer (FLOSSY_FMT)", "foo42",
+                     std::string(flossy::format_to(buffer, FLOSSY_FMT("foo{}"), 42)));
+
+  {
+    // Strings created with an allocator
+    std::allocator<char> const allocator;
+    assert_equal<char>("string flossy::format(allocator_arg, string)", "AA42XXfoo",
+                       flossy::format(std::allocator_arg, allocator, "AA{}XX{}", 42, "foo"));
+    assert_equal<char>("string flossy::format(allocator_arg, FLOSSY_FMT)", "AA42XXfoo",
+                       flossy::format(std::allocator_arg, allocator, FLOSSY_FMT("AA{}XX{}"), 42, "foo"));
+  }
+
+#ifdef __cpp_lib_memory_resource
+  {
+    // Strings created in a memory resource, without using the global heap
+    std::array<std::byte, 4096> storage;
+    std::pmr::monotonic_buffer_resource arena(storage.data(), storage.size(), std::pmr::null_memory_resource());
+    flossy::parsed_format<char> const parsed("{} and some more text to avoid the small string optimization {.3f}");
+
+    auto const before = allocations;
+    std::pmr::string const result = flossy::format(&arena, "{} and some more text to avoid the small string optimization {.3f}",
+                                                   42, 1.25);
+    std::pmr::string const compiled = flossy::format(&arena, FLOSSY_FMT("{} and some more text to avoid the small string optimization {.3f}"),
+                                                     42, 1.25);
+    std::pmr::string const parsed_result = flossy::format(&arena, parsed, 42, 1.25);
+    std::pmr::wstring const wide = flossy::format(&arena, L"{} and some more text to avoid the small string optimization {.3f}",
+                                                  42, 1.25);
+    auto const after = allocations;
+
+    std::string const expect = "42 and some more text to avoid the small string optimization 1.250";
+    assert_equal<char>("pmr::string flossy::format(memory_resource*, string)", expect, std::string(result));
+    assert_equal<char>("pmr::string flossy::format(memory_resource*, FLOSSY_FMT)", expect, std::string(compiled));
+    assert_equal<char>("pmr::string flossy::format(memory_resource*, parsed_format)", expect, std::string(parsed_result));
+    assert_equal<wchar_t>("pmr::wstring flossy::format(memory_resource*, wstring)", cheaty_cast_string<wchar_t>(expect),
+                          std::wstring(wide));
+    assert_equal<char>("pmr::string flossy::format(memory_resource*) allocations", "0", std::to_string(after - before));
+  }
+#endif
 
   std::cout << "Performed " << testcount << " tests, " << (testcount - failed) << " passed, " << failed << " failed." << std::endl;
+  return failed ? 1 : 0;
 }
@@ -0,0 +1,106 @@
+// Built with exceptions disabled (e.g. -fno-exceptions), where invalid format
+// strings are reported by check_format and try_format_to only.
+
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "Flossy/Flossy.hpp"
+#include "Flossy/AsyncSink.hpp"
+
+#ifndef FLOSSY_NO_EXCEPTIONS
+# error "Build this test with exceptions disabled"
+#endif
+
+int testcount = 0;
+int failed = 0;
+
+
+void assert_equal(std::string const& description, std::string const& expect, std::string const& result) {
+  ++testcount;
+
+  if (result != expect) {
+    std::cout << "Test failed: \"" << description << "\": \"" << result << "\" != \"" << expect << "\")\n";
+    ++failed;
+  }
+}
+
+
+std::string describe(flossy::format_status const& status) {
+  return status ? std::string("ok") : std::string(status.message()) + " at " + std::to_string(status.offset);
+}
+
+
+void test_valid_formats() {
+  assert_equal("format", "AAfooXX+0042YY", flossy::format("AA{}XX{_+05d}YY", "foo", 42));
+  assert_equal("format (FLOSSY_FMT)", "1.50 ff", flossy::format(FLOSSY_FMT("{.2f} {x}"), 1.5, 255));
+
+  flossy::parsed_format<char, 2> const checked("{} and {}");
+  assert_equal("format (parsed_format)", "1 and 2", flossy::format(checked, 1, 2));
+
+  std::ostringstream stream;
+  flossy::format(stream, "stream {}", 42);
+  assert_equal("format (ostream)", "stream 42", stream.str());
+
+  flossy::memory_buffer buffer;
+  assert_equal("format_to memory buffer", "buffer 42", std::string(flossy::format_to(buffer, "buffer {}", 42)));
+}
+
+
+void test_errors() {
+  assert_equal("check_format", "ok", describe(flossy::check_format("AA{}XX{{}}{<5s}")));
+  assert_equal("check_format (unterminated)", "unterminated { at 6", describe(flossy::check_format("AA{}XX{<5s")));
+  assert_equal("check_format (invalid)", "Invalid character in format string at 8",
+               describe(flossy::check_format("AA{}XX{<L}")));
+
+  std::string output;
+  auto const result = flossy::try_format_to(std::back_inserter(output), "AA{}XX{L}", 1, 2);
+  assert_equal("try_format_to (invalid)", "Invalid character in format string at 7", describe(result.status));
+  assert_equal("try_format_to (invalid) output", "", output);
+
+  auto const valid = flossy::try_format_to(std::back_inserter(output), "AA{}XX{L}", 1);
+  assert_equal("try_format_to (rest copied)", "ok", describe(valid.status));
+  assert_equal("try_format_to (rest copied) output", "AA1XX{L}", output);
+
+  flossy::memory_buffer buffer;
+  assert_equal("try_format_to memory buffer", "unterminated { at 3",
+               describe(flossy::try_format_to(buffer, "AA {", 1)));
+  assert_equal("try_format_to memory buffer output", "", buffer.str());
+}
+
+
+void test_async_sink() {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return;
+  }
+
+  {
+    flossy::async_sink sink(fds[1]);
+    sink.format("valid {}\n", 1);
+    sink.format("invalid {L}\n", 2);
+    sink.flush();
+    assert_equal("async_sink failed", "1", std::to_string(sink.failed()));
+  }
+  close(fds[1]);
+
+  std::string text;
+  char chunk[64];
+  for (ssize_t n; (n = read(fds[0], chunk, sizeof(chunk))) > 0;) {
+    text.append(chunk, std::size_t(n));
+  }
+  close(fds[0]);
+  assert_equal("async_sink output", "valid 1\n", text);
+}
+
+
+int main() {
+  test_valid_formats();
+  test_errors();
+  test_async_sink();
+
+  std::cout << "Performed " << testcount << " tests, " << (testcount - failed) << " passed, " << failed << " failed." << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+#define FLOSSY_ENABLE_STATS
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "Flossy/Flossy.hpp"
+#include "AllocationCounter.hpp"
+
+int testcount = 0;
+int failed = 0;
+
+
+void assert_equal(std::string const& description, std::string const& expect, std::string const& result) {
+  ++testcount;
+
+  if (result != expect) {
+    std::cout << "Test failed: \"" << description << "\": \"" << result << "\" != \"" << expect << "\")\n";
+    ++failed;
+  }
+}
+
+
+flossy::format_stats find(std::string const& format_str) {
+  for (auto const& stats : flossy::stats_snapshot()) {
+    if (stats.format_str == format_str) {
+      return stats;
+    }
+  }
+  return {};
+}
+
+
+void test_counters() {
+  flossy::stats_reset();
+
+  for (int i = 0; i < 10; ++i) {
+    flossy::format("value {} and {{escaped}} {<5s}!", i, "abc");
+  }
+
+  auto const stats = find("value {} and {{escaped}} {<5s}!");
+  assert_equal("stats calls", "10", std::to_string(stats.calls));
+  assert_equal("stats placeholders", "2", std::to_string(stats.placeholders));
+  // formatted_size is not recorded
+  assert_equal("stats bytes", std::to_string(10 * flossy::formatted_size("value {} and {{escaped}} {<5s}!", 0, "abc")),
+               std::to_string(stats.bytes));
+  assert_equal("stats time", "true", stats.nanoseconds > 0 ? "true" : "false");
+}
+
+
+void test_allocations() {
+  flossy::stats_reset();
+
+  // Floats are not cheaply sizable, so the result string grows
+  std::string const long_format(100, '.');
+  flossy::format(long_format + "{}", 1.5);
+
+  flossy::memory_buffer buffer;
+  for (int i = 0; i < 5; ++i) {
+    buffer.clear();
+    flossy::format_to(buffer, "no allocation {}", i);
+  }
+
+  assert_equal("stats allocations", "true", find(long_format + "{}").allocations > 0 ? "true" : "false");
+  assert_equal("stats memory_buffer allocations", "0", std::to_string(find("no allocation {}").allocations));
+}
+
+
+void test_outputs() {
+  flossy::stats_reset();
+
+  std::ostringstream stream;
+  flossy::format(stream, "stream {}\n", 12345);
+
+  char array[8];
+  flossy::format_to_n(array, sizeof(array), "truncated {}", 12345);
+
+  flossy::format(L"wide {}", 42);
+  flossy::format(FLOSSY_FMT("compiled {}"), 42);
+
+  assert_equal("stats stream bytes", "13", std::to_string(find("stream {}\n").bytes));
+  assert_equal("stats format_to_n bytes", "8", std::to_string(find("truncated {}").bytes));
+  assert_equal("stats wide bytes", std::to_string(7 * sizeof(wchar_t)), std::to_string(find("wide {}").bytes));
+  assert_equal("stats compiled calls", "1", std::to_string(find("compiled {}").calls));
+}
+
+
+void test_threads() {
+  flossy::stats_reset();
+
+  std::thread worker([] {
+    for (int i = 0; i < 100; ++i) {
+      flossy::format("thread {}", i);
+    }
+  });
+  worker.join();
+
+  for (int i = 0; i < 50; ++i) {
+    flossy::format("thread {}", i);
+  }
+
+  // The counts of ended threads are kept
+  assert_equal("stats threads", "150", std::to_string(find("thread {}").calls));
+
+  std::ostringstream dump;
+  flossy::stats_dump(dump);
+  assert_equal("stats dump", "true", dump.str().find("  thread {}\n") != std::string::npos ? "true" : "false");
+
+  flossy::stats_reset();
+  assert_equal("stats reset", "0", std::to_string(flossy::stats_snapshot().size()));
+}
+
+
+int main() {
+  allocation_hook = &flossy::stats_count_allocation;
+
+  test_counters();
+  test_allocations();
+  test_outputs();
+  test_threads();
+
+  std::cout << "Performed " << testcount << " tests, " << (testcount - failed) << " passed, " << failed << " failed." << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+// flossy-decode: formats the messages of binary logs written by
+// flossy::binary_writer and prints them to standard output.
+//
+//   flossy-decode [file...]
+//
+// Reads standard input if no file is given.
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "Flossy/BinaryLog.hpp"
+
+
+// Decode one binary log. Returns false on errors.
+bool decode(std::FILE* input, char const* name) {
+  flossy::binary_reader reader;
+  std::string pending;
+  std::string text;
+  char chunk[65536];
+
+  try {
+    for (std::size_t count; (count = std::fread(chunk, 1, sizeof(chunk), input)) > 0;) {
+      pending.append(chunk, count);
+      std::string_view bytes = pending;
+      reader.decode(std::back_inserter(text), bytes);
+      pending.erase(0, pending.size() - bytes.size());
+
+      std::fwrite(text.data(), 1, text.size(), stdout);
+      text.clear();
+    }
+  }
+  catch (std::exception const& error) {
+    std::cerr << "flossy-decode: " << name << ": " << error.what() << "\n";
+    return false;
+  }
+
+  if (std::ferror(input)) {
+    std::cerr << "flossy-decode: " << name << ": read error\n";
+    return false;
+  }
+  if (!pending.empty()) {
+    std::cerr << "flossy-decode: " << name << ": incomplete record at the end\n";
+    return false;
+  }
+  return true;
+}
+
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    return decode(stdin, "<stdin>") ? 0 : 1;
+  }
+
+  bool success = true;
+  for (int i = 1; i < argc; ++i) {
+    std::FILE* input = std::fopen(argv[i], "rb");
+    if (!input) {
+      std::cerr << "flossy-decode: cannot open " << argv[i] << "\n";
+      success = false;
+      continue;
+    }
+    success = decode(input, argv[i]) && success;
+    std::fclose(input);
+  }
+  return success ? 0 : 1;
+}